@@ -0,0 +1,343 @@
+#include "acquisition.h"
+#include "newavr-main.h"
+#include "decimator.h"
+#include "capture.h"
+/*
+ * Combined EMG and PPG acquisition. The muscle sensors are scanned from the
+ * TCB0 interrupt, one channel per interrupt in turn, so every channel is
+ * sampled at EMG_SAMPLE_RATE. Once all channels are read they go into the
+ * buffer as one sample, and the ISR also keeps an envelope per channel so
+ * extra channels cost the main loop nothing. The MAX30102 keeps filling its
+ * own FIFO. The main loop pulls from both through acquisition_next(), which
+ * timestamps every sample against millis() and hands them out in time order.
+ * The I2C work happens outside of any interrupt, so neither sensor loses
+ * samples as long as the main loop drains faster than the buffers fill.
+ *
+ * The MAX30102 runs at PPG_SENSOR_RATE. Its FIFO is read in bursts of up to
+ * MAX30102_BURST samples and decimated by PPG_DECIMATION with a half-band
+ * cascade (decimator.c) before the processing sees them, only the capture
+ * stream gets them undecimated. At 400 sps the 32 sample FIFO lasts 80 ms,
+ * the peak fill level is kept so the margin can be checked through the
+ * diagnostics.
+ */
+
+// Sensors enabled for the current session
+volatile uint8_t acq_sensors = 0;
+
+// EMG samples written by the ISR and read by the main loop
+RING_DEFINE(acq_emg_ring, acq_emg_scan_t, ACQ_EMG_BUFFER);
+volatile uint16_t acq_emg_dropped = 0;
+
+// Channel being converted and the readings of the scan so far
+volatile uint8_t acq_emg_channel = 0;
+volatile uint16_t acq_emg_scan[EMG_CHANNELS];
+
+// Per channel envelope kept by the ISR, with ACQ_ENVELOPE_SHIFT fraction
+// bits
+volatile uint32_t acq_emg_envelope[EMG_CHANNELS];
+
+// PPG samples known to be waiting in the sensor FIFO
+uint8_t acq_ppg_pending = 0;
+uint32_t acq_ppg_time = 0; // Time the FIFO was last checked
+uint16_t acq_ppg_dropped = 0;
+uint8_t acq_ppg_fifo_peak = 0; // Most samples ever found waiting in the FIFO
+
+// Samples read from the FIFO in the last burst
+uint8_t acq_ppg_burst[MAX30102_BURST * MAX30102_SAMPLE_BYTES];
+uint8_t acq_ppg_burst_count = 0;
+uint8_t acq_ppg_burst_pos = 0;
+
+#if PPG_DECIMATION != DECIMATOR_FACTOR
+#error "PPG_DECIMATION must match the decimator"
+#endif
+
+// Decimators for both channels and the sensor samples fed in towards the
+// next PPG sample
+decimator_t acq_ppg_ir_decimator;
+decimator_t acq_ppg_red_decimator;
+uint8_t acq_ppg_phase = 0;
+
+// EMG accumulated since the last PPG sample, to line the two up
+uint32_t acq_emg_sum = 0;
+uint8_t acq_emg_count = 0;
+uint16_t acq_emg_last = 0;
+
+/**
+ * Start a session that samples the given sensors
+ * @param sensors ACQ_EMG and/or ACQ_PPG
+ */
+void acquisition_start(uint8_t sensors) {
+    acquisition_stop();
+
+    ring_reset(&acq_emg_ring);
+    acq_ppg_pending = 0;
+    acq_ppg_burst_count = 0;
+    acq_ppg_burst_pos = 0;
+    acq_ppg_phase = 0;
+    decimator_reset(&acq_ppg_ir_decimator);
+    decimator_reset(&acq_ppg_red_decimator);
+    acq_emg_sum = 0;
+    acq_emg_count = 0;
+    acq_emg_channel = 0;
+    for (uint8_t i = 0; i < EMG_CHANNELS; i++) {
+        acq_emg_envelope[i] = 0;
+    }
+    acq_sensors = sensors;
+
+    if (sensors & ACQ_PPG) {
+        // Throw away anything collected before the session
+        MAX30102_clearFIFO();
+        acq_ppg_time = millis();
+    }
+
+    if (sensors & ACQ_EMG) {
+        // Periodic interrupt at the EMG scan rate
+        TCB0.CCMP = F_CPU / EMG_SCAN_RATE - 1;
+        TCB0.CNT = 0;
+        TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+        TCB0.INTFLAGS = TCB_CAPT_bm;
+        TCB0.INTCTRL = TCB_CAPT_bm;
+        TCB0.CTRLA = TCB_CLKSEL_CLKDIV1_gc | TCB_ENABLE_bm;
+        ADC_select(0);
+        ADC_start();
+    }
+}
+
+/**
+ * Stop the current session
+ */
+void acquisition_stop() {
+    TCB0.CTRLA = 0;
+    TCB0.INTCTRL = 0;
+    acq_sensors = 0;
+}
+
+/**
+ * Check the MAX30102 FIFO for new samples and work out when they were taken
+ */
+static void acquisition_check_ppg() {
+    uint8_t overflow = MAX30102_overflow();
+    uint8_t available = MAX30102_available();
+    acq_ppg_time = millis();
+
+    // On overflow the pointers are equal but the FIFO is full
+    if (overflow) {
+        acq_ppg_dropped += overflow;
+        available = 32;
+    }
+    if (available > acq_ppg_fifo_peak) {
+        acq_ppg_fifo_peak = available;
+    }
+    acq_ppg_pending = available;
+}
+
+/**
+ * Get the number of sensor samples not handed out yet, in the FIFO or in the
+ * last burst
+ * @return number of samples
+ */
+static uint8_t acquisition_ppg_unread() {
+    return acq_ppg_pending + acq_ppg_burst_count - acq_ppg_burst_pos;
+}
+
+/**
+ * Get the next sensor sample, reading a new burst from the FIFO when needed
+ * @param ppg where to put the sample
+ * @return true if a sample was read
+ */
+static bool acquisition_read_ppg(MAX30102_sample_t *ppg) {
+    if (acq_ppg_burst_pos == acq_ppg_burst_count) {
+        uint8_t count = acq_ppg_pending < MAX30102_BURST ? acq_ppg_pending : MAX30102_BURST;
+        acq_ppg_burst_pos = 0;
+        acq_ppg_burst_count = 0;
+        if (!MAX30102_buffer_data(count * MAX30102_SAMPLE_BYTES, acq_ppg_burst)) {
+            // The FIFO can't be trusted after a failed read, look again later
+            acq_ppg_dropped += acq_ppg_pending;
+            acq_ppg_pending = 0;
+            return false;
+        }
+        acq_ppg_pending -= count;
+        acq_ppg_burst_count = count;
+    }
+
+    MAX30102_decode_sample(&acq_ppg_burst[acq_ppg_burst_pos * MAX30102_SAMPLE_BYTES], ppg);
+    acq_ppg_burst_pos++;
+    return true;
+}
+
+/**
+ * Stream a sensor sample as read from the FIFO, before the decimator
+ * @param ppg sensor sample
+ * @param time when it was taken
+ */
+static void acquisition_capture_ppg(const MAX30102_sample_t *ppg, uint32_t time) {
+    if (!capture_is_enabled()) {
+        return;
+    }
+
+    acq_sample_t raw;
+    raw.type = ACQ_PPG;
+    raw.timestamp = time;
+    raw.emg = acq_emg_last;
+    raw.ir = ppg->ir;
+    raw.red = ppg->red;
+    capture_sample(&raw);
+}
+
+/**
+ * Get the next sample of the session in time order
+ * @param sample where to put the sample
+ * @return true if a sample was returned, false if nothing is waiting
+ */
+bool acquisition_next(acq_sample_t *sample) {
+    const acq_emg_scan_t *scan = ring_front(&acq_emg_ring);
+    bool have_emg = scan != NULL;
+    uint16_t emg_time = have_emg ? scan->time : 0;
+
+    // Sensor samples still needed for the next PPG sample
+    uint8_t needed = PPG_DECIMATION - acq_ppg_phase;
+
+    // Look for PPG samples whenever the next EMG sample is newer than the
+    // last look, so a PPG sample is never handed out after a later EMG one
+    if ((acq_sensors & ACQ_PPG) && acquisition_ppg_unread() < needed
+            && (!have_emg || (int16_t)(emg_time - (uint16_t)acq_ppg_time) > 0)) {
+        acquisition_check_ppg();
+    }
+
+    // Newest FIFO sample was taken about when the FIFO was checked, the older
+    // ones one sensor period apart before that. A PPG sample is stamped with
+    // the time of the last sensor sample that goes into it. The decimator
+    // delay (DECIMATOR_DELAY sensor samples) is left in, taking it out would
+    // stamp samples older than EMG samples already handed out.
+    uint8_t unread = acquisition_ppg_unread();
+    bool have_ppg = unread >= needed;
+    uint32_t ppg_time = acq_ppg_time;
+    if (have_ppg) {
+        ppg_time -= (uint32_t)(unread - needed) * PPG_SENSOR_PERIOD_US / 1000;
+    }
+
+    if (have_emg && (!have_ppg || (int16_t)(emg_time - (uint16_t)ppg_time) <= 0)) {
+        uint32_t now = millis();
+        sample->type = ACQ_EMG;
+        sample->timestamp = now - (uint16_t)((uint16_t)now - emg_time);
+        for (uint8_t i = 0; i < EMG_CHANNELS; i++) {
+            sample->emg_channels[i] = scan->value[i];
+        }
+        sample->emg = sample->emg_channels[0];
+        sample->ir = 0;
+        sample->red = 0;
+        ring_drop(&acq_emg_ring);
+
+        acq_emg_last = sample->emg;
+        acq_emg_sum += sample->emg;
+        acq_emg_count++;
+        capture_sample(sample);
+        return true;
+    }
+
+    if (have_ppg) {
+        MAX30102_sample_t ppg;
+        bool done = false;
+        while (!done) {
+            // Time of this sensor sample, for the capture stream
+            uint8_t left = acquisition_ppg_unread() - 1;
+            if (!acquisition_read_ppg(&ppg)) {
+                return false;
+            }
+            acquisition_capture_ppg(&ppg, acq_ppg_time - (uint32_t)left * PPG_SENSOR_PERIOD_US / 1000);
+
+            // Both channels are fed in step, so they finish together
+            decimator_push(&acq_ppg_red_decimator, ppg.red, &sample->red);
+            done = decimator_push(&acq_ppg_ir_decimator, ppg.ir, &sample->ir);
+            acq_ppg_phase = (acq_ppg_phase + 1) & (PPG_DECIMATION - 1);
+        }
+
+        sample->type = ACQ_PPG;
+        sample->timestamp = ppg_time;
+
+        // Mean EMG over the PPG sample period
+        sample->emg = acq_emg_count ? acq_emg_sum / acq_emg_count : acq_emg_last;
+        acq_emg_sum = 0;
+        acq_emg_count = 0;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Get the number of EMG samples lost because the buffer was full
+ * @return number of dropped samples
+ */
+uint16_t acquisition_dropped_emg() {
+    uint16_t dropped;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        dropped = acq_emg_dropped;
+    }
+    return dropped;
+}
+
+/**
+ * Get the number of PPG samples lost to a FIFO overflow on the MAX30102
+ * @return number of dropped samples
+ */
+uint16_t acquisition_dropped_ppg() {
+    return acq_ppg_dropped;
+}
+
+/**
+ * Get the fullest the MAX30102 FIFO has been when checked, anything below 32
+ * means the FIFO has never overflowed
+ * @return peak number of samples waiting
+ */
+uint8_t acquisition_ppg_fifo_peak() {
+    return acq_ppg_fifo_peak;
+}
+
+/**
+ * Get the smoothed reading of a muscle sensor
+ * @param channel index into EMG_CHANNEL_AIN
+ * @return envelope in ADC counts
+ */
+uint16_t acquisition_emg_envelope(uint8_t channel) {
+    uint32_t envelope;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        envelope = acq_emg_envelope[channel];
+    }
+    return envelope >> ACQ_ENVELOPE_SHIFT;
+}
+
+/**
+ * TCB0 interrupt to scan the muscle sensors, one channel per interrupt
+ */
+ISR(TCB0_INT_vect) {
+    // The conversion started last period has long finished, so store it and
+    // start the next channel
+    if (ADC_ready()) {
+        uint8_t channel = acq_emg_channel;
+        uint16_t value = ADC_result();
+        acq_emg_scan[channel] = value;
+
+        // Follow the channel with an exponential average
+        acq_emg_envelope[channel] += (int32_t)(((uint32_t)value << ACQ_ENVELOPE_SHIFT) - acq_emg_envelope[channel]) >> ACQ_ENVELOPE_SHIFT;
+
+        // Hand out the scan once every channel is in
+        if (++channel == EMG_CHANNELS) {
+            channel = 0;
+            acq_emg_scan_t *slot = ring_slot(&acq_emg_ring);
+            if (slot != NULL) {
+                for (uint8_t i = 0; i < EMG_CHANNELS; i++) {
+                    slot->value[i] = acq_emg_scan[i];
+                }
+                slot->time = (uint16_t)millis();
+                ring_commit(&acq_emg_ring);
+            } else {
+                acq_emg_dropped++;
+            }
+        }
+        acq_emg_channel = channel;
+        ADC_select(channel);
+    }
+    ADC_start();
+    TCB0.INTFLAGS = TCB_CAPT_bm;
+}
@@ -0,0 +1,57 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "muscle.h"
+#include "max30102.h"
+#include "ring.h"
+
+#ifndef ACQUISITION_H
+#define	ACQUISITION_H
+
+// Rate each muscle sensor is sampled at. TCB0 runs EMG_CHANNELS times as
+// fast and converts one channel per interrupt.
+#define EMG_SAMPLE_RATE 500
+#define EMG_SCAN_RATE ((uint32_t)EMG_SAMPLE_RATE * EMG_CHANNELS)
+
+// EMG samples (one reading of every channel) buffered between the ISR and
+// the main loop (power of two). 32 samples at 500 Hz gives the main loop
+// 64 ms to get back to draining
+#define ACQ_EMG_BUFFER 32
+
+// Smoothing of the per channel envelope kept by the ISR as a right shift
+// (1 / 2^shift per sample)
+#define ACQ_ENVELOPE_SHIFT 4
+
+// Sensors that can be part of an acquisition session
+#define ACQ_EMG 0x01
+#define ACQ_PPG 0x02
+
+// One scan of the muscle sensors as buffered by the ISR
+typedef struct {
+    uint16_t value[EMG_CHANNELS];
+    uint16_t time; // Low 16 bits of millis()
+} acq_emg_scan_t;
+
+// One entry in the common sample stream
+typedef struct {
+    uint32_t timestamp; // Milliseconds since startup, shared by both sensors
+    uint8_t type; // ACQ_EMG or ACQ_PPG
+    uint16_t emg; // EMG reading of the first channel, for PPG samples its mean over the sample period
+    uint16_t emg_channels[EMG_CHANNELS]; // Reading of every channel (EMG samples only)
+    uint32_t ir; // IR reading (PPG samples only)
+    uint32_t red; // Red reading (PPG samples only)
+} acq_sample_t;
+
+void acquisition_start(uint8_t sensors);
+void acquisition_stop();
+bool acquisition_next(acq_sample_t *sample);
+uint16_t acquisition_dropped_emg();
+uint16_t acquisition_dropped_ppg();
+uint8_t acquisition_ppg_fifo_peak();
+uint16_t acquisition_emg_envelope(uint8_t channel);
+ISR(TCB0_INT_vect);
+
+#endif	/* ACQUISITION_H */
+
@@ -0,0 +1,79 @@
+#include "baseline.h"
+/*
+ * Resting level of the muscle sensor followed over a session, so electrode
+ * drift and skin impedance changes do not skew the intensity. The readings
+ * are averaged into blocks and a block counts as rest when it and the
+ * BASELINE_SETTLE_BLOCKS before it stayed below BASELINE_ACTIVE_RATIO times
+ * the current level, which leaves out the reps and the moments around them.
+ * Each resting block moves the level one small step towards it, whatever
+ * the size of the difference. That tracks the median of the resting blocks,
+ * so a spike or a dropout moves the level no more than any other block.
+ */
+
+// Resting level in 1/16 count, 0 until a baseline is known
+uint16_t baseline_level = 0;
+
+// Block being averaged
+uint16_t baseline_block_sum = 0;
+uint8_t baseline_block_count = 0;
+
+// Quiet blocks in a row
+uint8_t baseline_quiet = 0;
+
+/**
+ * Start tracking from a measured baseline
+ * @param level resting muscle reading, 0 if none is known
+ */
+void baseline_set(uint16_t level) {
+    baseline_level = level << BASELINE_SHIFT;
+    baseline_block_sum = 0;
+    baseline_block_count = 0;
+    baseline_quiet = 0;
+}
+
+/**
+ * Add a muscle reading taken while the device is in a set or resting after it
+ * @param emg_val reading of the first muscle sensor
+ * @return true if the resting level moved
+ */
+bool baseline_update(uint16_t emg_val) {
+    // Nothing to gate the activity against until a baseline is measured
+    if (baseline_level == 0) {
+        return false;
+    }
+
+    baseline_block_sum += emg_val;
+    if (++baseline_block_count < BASELINE_BLOCK) {
+        return false;
+    }
+    uint16_t block = (baseline_block_sum + BASELINE_BLOCK / 2) / BASELINE_BLOCK;
+    baseline_block_sum = 0;
+    baseline_block_count = 0;
+
+    uint32_t limit = ((uint32_t)baseline_level * BASELINE_ACTIVE_RATIO) >> (8 + BASELINE_SHIFT);
+    if (block > limit) {
+        baseline_quiet = 0;
+        return false;
+    }
+    if (baseline_quiet < BASELINE_SETTLE_BLOCKS) {
+        baseline_quiet++;
+        return false;
+    }
+
+    uint16_t old = baseline_get();
+    uint16_t target = block << BASELINE_SHIFT;
+    if (target > baseline_level) {
+        baseline_level++;
+    } else if (target < baseline_level && baseline_level > (1 << BASELINE_SHIFT)) {
+        baseline_level--;
+    }
+    return baseline_get() != old;
+}
+
+/**
+ * Get the resting level
+ * @return resting muscle reading rounded to counts
+ */
+uint16_t baseline_get() {
+    return (baseline_level + (1 << (BASELINE_SHIFT - 1))) >> BASELINE_SHIFT;
+}
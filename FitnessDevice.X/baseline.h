@@ -0,0 +1,28 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BASELINE_H
+#define	BASELINE_H
+
+// Muscle readings averaged into one block (128 ms at 500 sps)
+#define BASELINE_BLOCK 64
+
+// A block above the resting level times this (in 1/256) is activity
+#define BASELINE_ACTIVE_RATIO 384
+
+// Quiet blocks in a row before the muscle is taken to be resting, so the
+// dip between the halves of a rep is not used
+#define BASELINE_SETTLE_BLOCKS 4
+
+// Fixed point of the estimate (1/16 count). It moves one step per resting
+// block, so it slews at most half a count per second.
+#define BASELINE_SHIFT 4
+
+// Change in counts worth writing to the calibration
+#define BASELINE_SAVE_DELTA 2
+
+void baseline_set(uint16_t level);
+bool baseline_update(uint16_t emg_val);
+uint16_t baseline_get();
+
+#endif	/* BASELINE_H */
@@ -1,4 +1,52 @@
 #include "bluetooth.h"
+#include "newavr-main.h"
+/*
+ * The RN4870 is brought up by a state machine that is stepped from the main
+ * loop with BLE_task(), so sensors and buttons work while the module boots.
+ * The USART is interrupt driven in both directions, and each command waits
+ * for its response without blocking. The module keeps its services across
+ * resets, so the setup is only sent when it is needed: after every boot the
+ * replies to GN (name) and LS (services) are hashed, and the setup is skipped
+ * only if that hash and the hash of the setup commands both match the ones
+ * stored in EEPROM after the last setup. A swapped or factory reset module
+ * answers LS differently and is set up again.
+ */
+
+// Commands that define the services, the name command is added in front
+static const char *const ble_config_commands[] = {
+    "PZ\r\n", // Remove all previously declared BLE services
+    "PS,1826\r\n", // Fitness Machine Service
+    "PC,2AD2,1C,20\r\n", // Physical Activity Level Characteristic
+    "PC,5A3C0001F2B84E519C1D0B8E4D7A2F10,02,14\r\n", // Device diagnostics (vendor specific)
+    "PC,5A3C0002F2B84E519C1D0B8E4D7A2F10,10,14\r\n", // Live telemetry, notify only (vendor specific)
+    "PC,5A3C0003F2B84E519C1D0B8E4D7A2F10,02,14\r\n", // Session energy estimate (vendor specific)
+    "PS,180D\r\n", // Heart Rate Service
+    "PC,2A37,10,14\r\n" // Heart Rate Measurement, notify only
+};
+#define BLE_CONFIG_COMMANDS (sizeof(ble_config_commands) / sizeof(ble_config_commands[0]))
+
+// Hash of the configuration the module was last set up with and of the
+// module's GN and LS replies right after that setup
+uint32_t EEMEM ble_config_hash_eeprom;
+uint32_t EEMEM ble_module_hash_eeprom;
+
+// USART buffers between the main loop and the ISRs
+RING_DEFINE(ble_tx, char, BLE_TX_SIZE);
+RING_DEFINE(ble_rx, char, BLE_RX_SIZE);
+
+// Bring-up and command engine state
+BLE_state_t ble_state = BLE_FAILED;
+BLE_state_t ble_after_response; // State to go to once the response arrives
+const char *ble_name;
+const char *ble_expect = NULL; // Response being waited on
+char ble_match[BLE_MATCH_SIZE + 1]; // Last characters received
+uint32_t ble_timer = 0;
+uint32_t ble_config_hash = 0;
+uint32_t ble_module_hash = 0; // Hash of the replies being checked
+bool ble_hash_response = false; // Add received chars to ble_module_hash
+bool ble_configured = false; // The setup was just sent, store the hashes
+uint8_t ble_config_step = 0;
+uint8_t ble_attempts = 0;
 
 /**
  * Initialize USART
@@ -11,18 +59,24 @@ void USART_init() {
     USART0.CTRLC = USART_CMODE_ASYNCHRONOUS_gc
             | USART_CHSIZE_8BIT_gc;
 
+    // Receive through the interrupt, the transmit interrupt is enabled when
+    // there is something to send
+    USART0.CTRLA = USART_RXCIE_bm;
+
     PORTA.DIR |= PIN0_bm;
     PORTA.DIR &= ~PIN1_bm;
 }
 
 /**
- * Writes a single char to USART
+ * Queues a single char to be written to USART, waits if the buffer is full
  * @param c char to write
  */
 void usartWriteChar(char c) {
-    // TODO fill this in
-    while (!(USART0.STATUS & USART_DREIF_bm)) { ; }        
-    USART0.TXDATAL = c;
+    char *slot;
+    while ((slot = ring_slot(&ble_tx)) == NULL) { ; }
+    *slot = c;
+    ring_commit(&ble_tx);
+    USART0.CTRLA |= USART_DREIE_bm;
 }
 
 /**
@@ -36,35 +90,133 @@ void usartWriteCommand(const char *cmd) {
 }
 
 /**
- * Reads a single char from USART
- * @return char from USART
+ * Reads a single char from USART if one was received
+ * @param c where to put the char
+ * @return true if a char was read
+ */
+bool usartReadChar(char *c) {
+    return ring_pop(&ble_rx, c);
+}
+
+/**
+ * Hash a string into a running FNV-1a hash
+ * @param hash hash so far
+ * @param str string to add
+ * @return updated hash
+ */
+static uint32_t ble_hash(uint32_t hash, const char *str) {
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * Get the hex digit for a nibble
+ * @param nibble value from 0 to 15
+ * @return uppercase hex digit
+ */
+static char ble_hex_digit(uint8_t nibble) {
+    return nibble < 10 ? '0' + nibble : 'A' + nibble - 10;
+}
+
+/**
+ * Send a command and wait (without blocking) for a response
+ * @param cmd command to send
+ * @param expect string that ends the response
+ * @param next state to go to once the response arrived
+ */
+static void ble_command(const char *cmd, const char *expect, BLE_state_t next) {
+    char c;
+
+    // Drop what is left of an abandoned command's response so it is not
+    // taken for this one
+    while (usartReadChar(&c)) { ; }
+    ble_match[0] = '\0';
+    ble_expect = expect;
+    ble_after_response = next;
+    ble_timer = millis();
+    usartWriteCommand(cmd);
+}
+
+/**
+ * Start the bring-up again from a module reset, or give up
+ */
+static void ble_restart() {
+    if (++ble_attempts >= BLE_MAX_ATTEMPTS) {
+        // Stop waiting so the timeout does not fire again
+        ble_expect = NULL;
+        ble_state = BLE_FAILED;
+        return;
+    }
+    PORTD.OUTCLR = PIN3_bm;
+    ble_expect = NULL;
+    ble_timer = millis();
+    ble_state = BLE_RESET;
+}
+
+/**
+ * Send the name command, which depends on the name given to BLE_init()
+ * @param next state to go to once the response arrived
  */
-char usartReadChar() {
-    while (!(USART0.STATUS & USART_RXCIF_bm));
-    return USART0.RXDATAL;
+static void ble_name_command(BLE_state_t next) {
+    scratch_mark_t mark = scratch_begin();
+    uint8_t size = strlen(ble_name) + 6;
+    char *command = scratch_alloc(size);
+    if (command == NULL) {
+        ble_restart();
+        return;
+    }
+    snprintf(command, size, "S-,%s\r\n", ble_name);
+    ble_command(command, BLE_RADIO_PROMPT, next);
+    scratch_end(mark);
 }
 
 /**
- * 
- * @param dest where to read the bytes too
- * @param end_str string signifying the end of transmission
+ * Check received chars against the response being waited on
+ * @return true if the response has arrived
  */
-void usartReadUntil(char *dest, const char *end_str) {
-    // Zero out dest memory so we always have null terminator at end
-    memset(dest, 0, BUF_SIZE);
-    uint8_t end_len = strlen(end_str);
-    uint8_t bytes_read = 0;
-    while (bytes_read < end_len || strcmp(dest + bytes_read - end_len, end_str) != 0) {
-        dest[bytes_read] = usartReadChar();
-        bytes_read++;
+static bool ble_response_received() {
+    char c;
+    uint8_t expect_len = strlen(ble_expect);
+    while (usartReadChar(&c)) {
+        // Keep the last few characters as a null terminated string
+        uint8_t len = strlen(ble_match);
+        if (len == BLE_MATCH_SIZE) {
+            memmove(ble_match, ble_match + 1, BLE_MATCH_SIZE - 1);
+            len--;
+        }
+        ble_match[len] = c;
+        ble_match[len + 1] = '\0';
+
+        if (ble_hash_response) {
+            ble_module_hash ^= (uint8_t)c;
+            ble_module_hash *= 16777619UL;
+        }
+
+        if (len + 1 >= expect_len && strcmp(ble_match + len + 1 - expect_len, ble_expect) == 0) {
+            return true;
+        }
     }
+    return false;
 }
 
 /**
- * Initialize BLE communication
+ * Initialize BLE communication, the rest of the bring-up happens in BLE_task()
  * @param name name of BLE Device to broadcast
  */
 void BLE_init(const char *name) {
+    ble_name = name;
+    ble_attempts = 0;
+    ble_configured = false;
+
+    // Hash of everything the configuration sends
+    ble_config_hash = ble_hash(2166136261UL, name);
+    for (uint8_t i = 0; i < BLE_CONFIG_COMMANDS; i++) {
+        ble_config_hash = ble_hash(ble_config_hash, ble_config_commands[i]);
+    }
+
     // Put BLE Radio in "Application Mode" by driving F3 high
     PORTF.DIRSET = PIN3_bm;
     PORTF.OUTSET = PIN3_bm;
@@ -72,54 +224,171 @@ void BLE_init(const char *name) {
     // Reset BLE Module - pull PD3 low, then back high after a delay
     PORTD.DIRSET = PIN3_bm | PIN2_bm;
     PORTD.OUTCLR = PIN3_bm;
-    _delay_ms(10); // Leave reset signal pulled low
-    PORTD.OUTSET = PIN3_bm;
-
-    // The AVR-BLE hardware guide is wrong. Labels this as D3
-    // Tell BLE module to expect data - set D2 low
-    PORTD.OUTCLR = PIN2_bm;
-    _delay_ms(200); // Give time for RN4870 to boot up
-
-    char buf[BUF_SIZE];
-    // Put RN4870 in Command Mode
-    usartWriteCommand("$$$");
-    usartReadUntil(buf, BLE_RADIO_PROMPT);
-
-    // Change BLE device name to specified value
-    strcpy(buf, "S-,");
-    strcat(buf, name);
-    strcat(buf, "\r\n");
-    usartWriteCommand(buf);
-    usartReadUntil(buf, BLE_RADIO_PROMPT);
-
-    // Send command to remove all previously declared BLE services
-    usartWriteCommand("PZ\r\n");
-    usartReadUntil(buf, "AOK\r\n");
-    // Fitness Machine Service
-    usartWriteCommand("PS,1826\r\n");
-    usartReadUntil(buf, "AOK\r\n");
-    // Physical Activity Level Characteristic
-    usartWriteCommand("PC,2AD2,1C,20\r\n");
-    // USED TO GET THE ADDRESS OF THE CHARACTERISTIC
-    usartReadUntil(buf, "AOK\r\n");
-    usartWriteCommand("LS,2AD2\r\n");
-    usartReadUntil(buf, BLE_RADIO_PROMPT);
-    // Set the characteristic's initial value to hex "00".
-    usartWriteCommand("SHW,0072,00\r\n");
-    usartReadUntil(buf, "AOK\r\n");
-}
-
-/**
- * Sends data over BLE
- * @param data The array of data to be sent
- * @param length The length of the data being sent
- */
-void BLE_send_data(uint16_t *data, size_t length) {
-    char buf[BUF_SIZE];
-    char command[BUF_SIZE];
-    for (int i = 0; i < length; i++) {
-        snprintf(command, sizeof(command), "SHW,0072,%04X\r\n", data[i]);
-        usartWriteCommand(command);
-        usartReadUntil(buf, BLE_RADIO_PROMPT);
+    ble_timer = millis();
+    ble_state = BLE_RESET;
+}
+
+/**
+ * Step the BLE bring-up and command engine, call this from the main loop
+ */
+void BLE_task() {
+    // Gave up on the module, a late response must not revive it
+    if (ble_state == BLE_FAILED) {
+        return;
+    }
+
+    // Waiting on a response from the module
+    if (ble_expect != NULL) {
+        if (ble_response_received()) {
+            ble_expect = NULL;
+            ble_state = ble_after_response;
+            if (ble_state == BLE_READY) {
+                ble_attempts = 0;
+            }
+        } else if (millis() - ble_timer >= BLE_RESPONSE_TIMEOUT) {
+            if (ble_state == BLE_BUSY) {
+                // A write after bring-up is abandoned, resetting the module
+                // would drop the connection
+                ble_expect = NULL;
+                ble_state = BLE_READY;
+            } else {
+                ble_restart();
+            }
+        }
+        return;
+    }
+
+    switch (ble_state) {
+        case BLE_RESET:
+            // Leave reset signal pulled low
+            if (millis() - ble_timer >= BLE_RESET_TIME) {
+                PORTD.OUTSET = PIN3_bm;
+
+                // The AVR-BLE hardware guide is wrong. Labels this as D3
+                // Tell BLE module to expect data - set D2 low
+                PORTD.OUTCLR = PIN2_bm;
+                ble_timer = millis();
+                ble_state = BLE_BOOTING;
+            }
+            break;
+        case BLE_BOOTING:
+            // Give time for RN4870 to boot up, then put it in Command Mode
+            if (millis() - ble_timer >= BLE_BOOT_TIME) {
+                ble_config_step = 0;
+                ble_command("$$$", BLE_RADIO_PROMPT, BLE_ENTER_COMMAND);
+            }
+            break;
+        case BLE_ENTER_COMMAND:
+            // Read back what the module is set up with
+            ble_module_hash = 2166136261UL;
+            ble_hash_response = true;
+            ble_command("GN\r\n", BLE_RADIO_PROMPT, BLE_CHECK_SERVICES);
+            break;
+        case BLE_CHECK_SERVICES:
+            ble_command("LS\r\n", BLE_RADIO_PROMPT, BLE_CHECKED);
+            break;
+        case BLE_CHECKED:
+            ble_hash_response = false;
+            if (ble_configured) {
+                // First check after a setup, remember what it looks like
+                ble_configured = false;
+                eeprom_update_dword(&ble_config_hash_eeprom, ble_config_hash);
+                eeprom_update_dword(&ble_module_hash_eeprom, ble_module_hash);
+                ble_attempts = 0;
+                ble_state = BLE_READY;
+            } else if (eeprom_read_dword(&ble_config_hash_eeprom) == ble_config_hash
+                    && eeprom_read_dword(&ble_module_hash_eeprom) == ble_module_hash) {
+                // Skip the setup if the module already has this configuration
+                ble_attempts = 0;
+                ble_state = BLE_READY;
+            } else {
+                ble_config_step = 0;
+                ble_name_command(BLE_CONFIGURING);
+            }
+            break;
+        case BLE_CONFIGURING:
+            if (ble_config_step < BLE_CONFIG_COMMANDS) {
+                ble_command(ble_config_commands[ble_config_step++], BLE_RADIO_PROMPT, BLE_CONFIGURING);
+            } else {
+                // Services only take effect after a reboot, the hashes are
+                // stored once the module is read back after it
+                ble_configured = true;
+                ble_command("R,1\r\n", BLE_REBOOT_MESSAGE, BLE_REBOOTING);
+            }
+            break;
+        case BLE_REBOOTING:
+            ble_command("$$$", BLE_RADIO_PROMPT, BLE_ENTER_COMMAND);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Get the state of the BLE module
+ * @return current state
+ */
+BLE_state_t BLE_get_state() {
+    return ble_state;
+}
+
+/**
+ * Check if the module is ready to take a new command
+ * @return true if a value can be sent
+ */
+bool BLE_is_ready() {
+    return ble_state == BLE_READY && ble_expect == NULL;
+}
+
+/**
+ * Starts sending a block of bytes over BLE, the response is handled by
+ * BLE_task()
+ * @param handle characteristic to write
+ * @param data bytes to write
+ * @param len number of bytes, at most BLE_MAX_DATA
+ * @return true if the data was sent, false if the module is busy
+ */
+bool BLE_send_data(uint16_t handle, const uint8_t *data, uint8_t len) {
+    if (!BLE_is_ready() || len > BLE_MAX_DATA) {
+        return false;
+    }
+
+    // "SHW,hhhh," + two hex digits per byte + "\r\n"
+    scratch_mark_t mark = scratch_begin();
+    char *command = scratch_alloc(12 + 2 * len);
+    if (command == NULL) {
+        return false;
+    }
+    uint8_t pos = snprintf(command, 10, "SHW,%04X,", handle);
+    for (uint8_t i = 0; i < len; i++) {
+        command[pos++] = ble_hex_digit(data[i] >> 4);
+        command[pos++] = ble_hex_digit(data[i] & 0x0F);
+    }
+    strcpy(command + pos, "\r\n");
+
+    ble_state = BLE_BUSY;
+    ble_command(command, BLE_RADIO_PROMPT, BLE_READY);
+    scratch_end(mark);
+    return true;
+}
+
+/**
+ * USART receive interrupt, stores the char for BLE_task()
+ */
+ISR(USART0_RXC_vect) {
+    char c = USART0.RXDATAL;
+    ring_push(&ble_rx, &c);
+}
+
+/**
+ * USART data register empty interrupt, sends the next queued char
+ */
+ISR(USART0_DRE_vect) {
+    const char *c = ring_front(&ble_tx);
+    if (c != NULL) {
+        USART0.TXDATAL = *c;
+        ring_drop(&ble_tx);
+    } else {
+        USART0.CTRLA &= ~USART_DREIE_bm;
     }
-}
\ No newline at end of file
+}
@@ -1,29 +1,77 @@
 #ifndef F_CPU
-#define F_CPU 3333333
+#define F_CPU 10000000
 #endif
 
 #include <avr/io.h>
+#include <avr/eeprom.h>
 #include <util/delay.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <avr/interrupt.h>
+#include "scratch.h"
+#include "ring.h"
 
-#define BUF_SIZE 128
 #define BLE_RADIO_PROMPT "CMD> "
+#define BLE_REBOOT_MESSAGE "%REBOOT%"
 #define SAMPLES_PER_BIT 16
 #define USART_BAUD_VALUE(BAUD_RATE) (uint16_t) ((F_CPU << 6) / (((float) SAMPLES_PER_BIT) * (BAUD_RATE)) + 0.5)
 
+// Sizes of the interrupt driven USART buffers (powers of two)
+#define BLE_TX_SIZE 64
+#define BLE_RX_SIZE 32
+
+// Longest response the module is waited on for
+#define BLE_MATCH_SIZE 8
+
+// Timing of the bring-up in ms. A response that times out during the
+// bring-up resets the module, up to BLE_MAX_ATTEMPTS times in a row, one
+// that times out after it only abandons that command.
+#define BLE_RESET_TIME 10
+#define BLE_BOOT_TIME 200
+#define BLE_RESPONSE_TIMEOUT 1000
+#define BLE_MAX_ATTEMPTS 3
+
+// Handles of the characteristic values, the module numbers them in the
+// order they are declared (Physical Activity Level, telemetry and Heart
+// Rate Measurement have a CCCD after them, a service declaration takes one)
+#define BLE_ACTIVITY_HANDLE 0x0072
+#define BLE_DIAGNOSTICS_HANDLE 0x0075
+#define BLE_TELEMETRY_HANDLE 0x0077
+#define BLE_ENERGY_HANDLE 0x007A
+#define BLE_HEART_RATE_HANDLE 0x007D
+
+// Most bytes written to a characteristic at once
+#define BLE_MAX_DATA 20
 
 #ifndef BLUETOOTH_H
 #define	BLUETOOTH_H
 
+// States of the BLE bring-up and command engine
+typedef enum {
+    BLE_RESET,
+    BLE_BOOTING,
+    BLE_ENTER_COMMAND,
+    BLE_CHECK_SERVICES,
+    BLE_CHECKED,
+    BLE_CONFIGURING,
+    BLE_REBOOTING,
+    BLE_READY,
+    BLE_BUSY,
+    BLE_FAILED
+} BLE_state_t;
+
 void USART_init();
 void usartWriteChar(char c);
 void usartWriteCommand(const char *cmd);
-char usartReadChar();
-void usartReadUntil(char *dest, const char *end_str);
+bool usartReadChar(char *c);
 void BLE_init(const char *name);
-void BLE_send_data(uint16_t *data, size_t length);
+void BLE_task();
+BLE_state_t BLE_get_state();
+bool BLE_is_ready();
+bool BLE_send_data(uint16_t handle, const uint8_t *data, uint8_t len);
+ISR(USART0_RXC_vect);
+ISR(USART0_DRE_vect);
 
 #endif	/* BLUETOOTH_H */
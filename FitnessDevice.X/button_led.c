@@ -1,51 +1,126 @@
 #include "button_led.h"
+/*
+ * The buttons are sampled from the RTC periodic interrupt rather than on
+ * pin change, which debounces them for free. Presses are turned into
+ * gestures (short, long, double) and queued for the main loop.
+ */
+
+button_t buttons[BUTTON_COUNT];
+
+// Gesture events written by the ISR and read by the main loop
+RING_DEFINE(button_events, uint8_t, BUTTON_QUEUE_SIZE);
 
 /**
  * Initialize the buttons
  */
 void button_init() {
     PORTA.DIR &= ~PIN6_bm;
-    PORTA.PIN6CTRL = PORT_PULLUPEN_bm | PORT_ISC_RISING_gc;
+    PORTA.PIN6CTRL = PORT_PULLUPEN_bm;
     PORTA.DIR &= ~PIN4_bm;
-    PORTA.PIN4CTRL = PORT_PULLUPEN_bm | PORT_ISC_RISING_gc;
-    RED_BUTTON_INTERRUPT_CLEAR;
-    YELLOW_BUTTON_INTERRUPT_CLEAR;
+    PORTA.PIN4CTRL = PORT_PULLUPEN_bm;
+
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        buttons[i].history = 0;
+        buttons[i].pressed = false;
+        buttons[i].long_sent = false;
+        buttons[i].held = 0;
+        buttons[i].since_release = UINT8_MAX;
+    }
+
+    // Periodic interrupt from the 32.768 kHz RTC clock, 32768 / 256 = 128 Hz
+    while (RTC.PITSTATUS > 0) {;}
+    RTC.PITINTCTRL = RTC_PI_bm;
+    RTC.PITCTRLA = RTC_PERIOD_CYC256_gc | RTC_PITEN_bm;
 }
 
 /**
- * Function to set the LED color
- * @param red 1 for on, 0 for off
- * @param green 1 for on, 0 for off
- * @param blue 1 for on, 0 for off
+ * Queue a gesture for the main loop, dropped if the queue is full
+ * @param button button id
+ * @param gesture gesture that happened
  */
-void set_LED_color(uint8_t red, uint8_t green, uint8_t blue) {
-    // Control the red channel (Port D7)
-    if (red) {
-        PORTD.OUTSET = PIN7_bm; // Turn on red
-    } else {
-        PORTD.OUTCLR = PIN7_bm; // Turn off red
+static void button_queue_event(uint8_t button, button_gesture_t gesture) {
+    uint8_t event = (button << 4) | gesture;
+    ring_push(&button_events, &event);
+}
+
+/**
+ * Debounce one button and detect its gestures, called every tick
+ * @param id button id
+ * @param raw_pressed true if the pin reads pressed right now
+ */
+static void button_update(uint8_t id, bool raw_pressed) {
+    button_t *b = &buttons[id];
+    b->history = (b->history << 1) | raw_pressed;
+
+    if (b->since_release < UINT8_MAX) {
+        b->since_release++;
     }
 
-    // Control the green channel (Port D5)
-    if (green) {
-        PORTD.OUTSET = PIN5_bm; // Turn on green
-    } else {
-        PORTD.OUTCLR = PIN5_bm; // Turn off green
+    if (!b->pressed && (b->history & BUTTON_DEBOUNCE_MASK) == BUTTON_DEBOUNCE_MASK) {
+        // Press
+        b->pressed = true;
+        b->long_sent = false;
+        b->held = 0;
+    } else if (b->pressed && (b->history & BUTTON_DEBOUNCE_MASK) == 0) {
+        // Release, a long press was already reported while held
+        b->pressed = false;
+        if (!b->long_sent) {
+            button_queue_event(id, BUTTON_SHORT);
+            if (b->since_release < BUTTON_DOUBLE_TICKS) {
+                button_queue_event(id, BUTTON_DOUBLE);
+                b->since_release = UINT8_MAX;
+            } else {
+                b->since_release = 0;
+            }
+        }
+    } else if (b->pressed && !b->long_sent) {
+        if (++b->held >= BUTTON_LONG_TICKS) {
+            button_queue_event(id, BUTTON_LONG);
+            b->long_sent = true;
+            b->since_release = UINT8_MAX;
+        }
     }
+}
 
-    // Control the blue channel (Port A7)
-    if (blue) {
-        PORTA.OUTSET = PIN7_bm; // Turn on blue
-    } else {
-        PORTA.OUTCLR = PIN7_bm; // Turn off blue
+/**
+ * Get the next button gesture
+ * @param button where to put the button id
+ * @param gesture where to put the gesture
+ * @return true if there was an event
+ */
+bool button_get_event(uint8_t *button, button_gesture_t *gesture) {
+    uint8_t event;
+    if (!ring_pop(&button_events, &event)) {
+        return false;
     }
+    *button = event >> 4;
+    *gesture = (button_gesture_t)(event & 0x0F);
+    return true;
+}
+
+/**
+ * Function to set the LED color
+ * @param red 1 for on, 0 for off
+ * @param green 1 for on, 0 for off
+ * @param blue 1 for on, 0 for off
+ */
+void set_LED_color(uint8_t red, uint8_t green, uint8_t blue) {
+    feedback_set_color(red ? 255 : 0, green ? 255 : 0, blue ? 255 : 0);
+    feedback_set_brightness(255);
 }
 
 /**
- * Initialize the LED
+ * Initialize the LED, the pins are driven by the feedback PWM
  */
 void LED_init() {
-    // Set Port D7, D5, and A7 as output
-    PORTD.DIRSET = PIN7_bm | PIN5_bm;
-    PORTA.DIRSET = PIN7_bm;
+    feedback_init();
+}
+
+/**
+ * RTC periodic interrupt to sample the buttons
+ */
+ISR(RTC_PIT_vect) {
+    button_update(BUTTON_RED, RED_BUTTON_PRESSED);
+    button_update(BUTTON_YELLOW, YELLOW_BUTTON_PRESSED);
+    RTC.PITINTFLAGS = RTC_PI_bm;
 }
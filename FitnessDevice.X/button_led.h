@@ -1,24 +1,61 @@
 #ifndef F_CPU
-#define F_CPU 3333333
+#define F_CPU 10000000
 #endif
 
 #include <util/delay.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <avr/interrupt.h>
+#include "feedback.h"
+#include "ring.h"
 
 #ifndef BUTTON_LED_H
 #define	BUTTON_LED_H
 
-#define RED_BUTTON_INTERRUPT (PORTA.INTFLAGS & PIN6_bm)
-#define RED_BUTTON_INTERRUPT_CLEAR (PORTA.INTFLAGS = PIN6_bm)
-#define YELLOW_BUTTON_INTERRUPT (PORTA.INTFLAGS & PIN4_bm)
-#define YELLOW_BUTTON_INTERRUPT_CLEAR (PORTA.INTFLAGS = PIN4_bm)
+// Buttons are active low (pullups enabled)
+#define RED_BUTTON_PRESSED (!(PORTA.IN & PIN6_bm))
+#define YELLOW_BUTTON_PRESSED (!(PORTA.IN & PIN4_bm))
+
+// Button ids
+#define BUTTON_RED 0
+#define BUTTON_YELLOW 1
+#define BUTTON_COUNT 2
+
+// The buttons are sampled by the RTC periodic interrupt at 128 Hz
+#define BUTTON_TICK_RATE 128
+#define BUTTON_MS_TO_TICKS(ms) ((uint32_t)(ms) * BUTTON_TICK_RATE / 1000)
+
+// Gesture timing
+#define BUTTON_DEBOUNCE_MASK 0x07 // 3 equal samples (~23 ms) to change state
+#define BUTTON_LONG_TICKS BUTTON_MS_TO_TICKS(1000)
+#define BUTTON_DOUBLE_TICKS BUTTON_MS_TO_TICKS(300)
+
+// Events waiting for the main loop (power of two)
+#define BUTTON_QUEUE_SIZE 8
+
+// Gestures reported for a button
+typedef enum {
+    BUTTON_SHORT = 1, // Released before BUTTON_LONG_TICKS
+    BUTTON_LONG, // Held for BUTTON_LONG_TICKS, sent while still held
+    BUTTON_DOUBLE // Second short press within BUTTON_DOUBLE_TICKS, follows a SHORT
+} button_gesture_t;
+
+// Struct for the debounce and gesture state of a button
+typedef struct {
+    uint8_t history; // Last raw samples, newest in bit 0
+    bool pressed; // Debounced state
+    bool long_sent; // Long press already reported for this press
+    uint8_t held; // Ticks the button has been held
+    uint8_t since_release; // Ticks since the last short press ended
+} button_t;
 
 void button_init();
+bool button_get_event(uint8_t *button, button_gesture_t *gesture);
 void LED_init();
 void set_LED_color(uint8_t red, uint8_t green, uint8_t blue);
+ISR(RTC_PIT_vect);
 
 #endif	/* BUTTON_LED_H */
 
@@ -0,0 +1,96 @@
+#include "calibration.h"
+/*
+ * Persistent calibration so a session can start without re-baselining.
+ * The record is kept in CAL_SLOTS EEPROM slots. Each save goes to the slot
+ * after the newest one with the next sequence number, so no single slot
+ * takes every write, and a save that is interrupted leaves the previous
+ * record intact. Records are only written when something changed.
+ */
+
+calibration_t EEMEM calibration_eeprom[CAL_SLOTS];
+
+// Slot and contents of the newest valid record
+int8_t cal_slot = -1;
+calibration_t cal_stored;
+
+/**
+ * Compute the CRC of a record
+ * @param cal record to check
+ * @return CRC-16/CCITT of the record without its crc field
+ */
+static uint16_t calibration_crc(const calibration_t *cal) {
+    const uint8_t *data = (const uint8_t *)cal;
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < offsetof(calibration_t, crc); i++) {
+        crc = _crc_ccitt_update(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * Fill a record with the built in defaults
+ * @param cal record to fill
+ */
+void calibration_defaults(calibration_t *cal) {
+    memset(cal, 0, sizeof(*cal));
+    cal->version = CAL_VERSION;
+    cal->spo2_a = CAL_DEFAULT_SPO2_A;
+    cal->spo2_b = CAL_DEFAULT_SPO2_B;
+    cal->beat_min = CAL_DEFAULT_BEAT_MIN;
+    cal->beat_max = CAL_DEFAULT_BEAT_MAX;
+    cal->ir_amplitude = CAL_DEFAULT_IR_AMPLITUDE;
+    cal->red_amplitude = CAL_DEFAULT_RED_AMPLITUDE;
+}
+
+/**
+ * Load the newest valid record from EEPROM
+ * @param cal where to put the record, filled with defaults if none is valid
+ * @return true if a stored record was found
+ */
+bool calibration_load(calibration_t *cal) {
+    calibration_t slot;
+    cal_slot = -1;
+
+    for (uint8_t i = 0; i < CAL_SLOTS; i++) {
+        eeprom_read_block(&slot, &calibration_eeprom[i], sizeof(slot));
+        if (slot.version != CAL_VERSION || slot.crc != calibration_crc(&slot)) {
+            continue;
+        }
+        // Sequence numbers wrap, so compare them as a signed difference
+        if (cal_slot < 0 || (int8_t)(slot.sequence - cal_stored.sequence) > 0) {
+            cal_slot = i;
+            cal_stored = slot;
+        }
+    }
+
+    if (cal_slot < 0) {
+        calibration_defaults(cal);
+        return false;
+    }
+    *cal = cal_stored;
+    return true;
+}
+
+/**
+ * Store a record if it differs from the one in EEPROM
+ * @param cal record to store, its sequence and crc are filled in
+ * @return true if anything was written
+ */
+bool calibration_save(calibration_t *cal) {
+    cal->version = CAL_VERSION;
+    if (cal_slot >= 0) {
+        cal->sequence = cal_stored.sequence;
+        cal->crc = cal_stored.crc;
+        if (memcmp(cal, &cal_stored, sizeof(*cal)) == 0) {
+            return false;
+        }
+        cal->sequence = cal_stored.sequence + 1;
+    }
+    cal->crc = calibration_crc(cal);
+
+    // Write the next slot, the current newest stays valid until this is done
+    cal_slot = (cal_slot + 1) % CAL_SLOTS;
+    eeprom_update_block(cal, &calibration_eeprom[cal_slot], sizeof(*cal));
+    cal_stored = *cal;
+    return true;
+}
@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#ifndef CALIBRATION_H
+#define	CALIBRATION_H
+
+// Bump when the layout of calibration_t changes, old records are then ignored
+#define CAL_VERSION 1
+
+// Number of EEPROM slots the record rotates through to spread the writes
+#define CAL_SLOTS 4
+
+// Defaults used when no valid record is stored
+#define CAL_DEFAULT_SPO2_A 11000 // 110.00
+#define CAL_DEFAULT_SPO2_B 2500 // 25.00
+#define CAL_DEFAULT_BEAT_MIN 40
+#define CAL_DEFAULT_BEAT_MAX 1300
+#define CAL_DEFAULT_IR_AMPLITUDE 0x1F
+#define CAL_DEFAULT_RED_AMPLITUDE 0x0A
+
+// Calibration record as stored in EEPROM
+typedef struct {
+    uint8_t version;
+    uint8_t sequence; // Incremented on every save, the newest slot wins
+    uint16_t emg_baseline; // Resting muscle sensor average, 0 if never measured
+    int16_t spo2_a; // SpO2 = a - b * R, both in hundredths
+    int16_t spo2_b;
+    int16_t beat_min; // Allowed IR AC amplitude window for a beat
+    int16_t beat_max;
+    uint8_t ir_amplitude; // MAX30102 LED pulse amplitudes
+    uint8_t red_amplitude;
+    uint16_t crc; // CRC-16/CCITT of everything above
+} calibration_t;
+
+void calibration_defaults(calibration_t *cal);
+bool calibration_load(calibration_t *cal);
+bool calibration_save(calibration_t *cal);
+
+#endif	/* CALIBRATION_H */
+
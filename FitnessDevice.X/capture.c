@@ -0,0 +1,114 @@
+#include "capture.h"
+/*
+ * Capture mode streams the raw samples out of USART1 in small binary frames,
+ * for tuning the signal processing on a PC with tools/capture_decode.py.
+ * acquisition.c hands over every EMG sample and every MAX30102 sample as it
+ * comes out of the FIFO, at PPG_SENSOR_RATE and before the decimator, so the
+ * filters can be redesigned from the capture. Only the first muscle sensor
+ * is streamed, the other EMG channels are left out to keep the frames small;
+ * a PPG frame carries the latest reading of that sensor. A frame that does
+ * not fit in the transmit buffer is dropped whole but still uses up a
+ * sequence number, so the decoder can tell exactly how many frames were lost.
+ * The gaps it counts are the only record of the drops, the device keeps no
+ * count of its own since the diagnostics record has no room left for one.
+ */
+
+// Frames written by the main loop and sent by the ISR
+RING_DEFINE(capture_ring, uint8_t, CAPTURE_BUFFER);
+
+bool capture_enabled = false;
+uint8_t capture_sequence = 0;
+
+/**
+ * Initialize USART1 for the capture stream, transmit only
+ */
+void capture_init() {
+    PORTC.DIRSET = PIN0_bm;
+    USART1.BAUD = USART_BAUD_VALUE(CAPTURE_BAUD);
+    USART1.CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc;
+    USART1.CTRLB = USART_TXEN_bm;
+}
+
+/**
+ * Turn capture mode on or off
+ * @param enable true to start streaming samples
+ */
+void capture_enable(bool enable) {
+    capture_enabled = enable;
+}
+
+/**
+ * Check if capture mode is on
+ * @return true if samples are being streamed
+ */
+bool capture_is_enabled() {
+    return capture_enabled;
+}
+
+/**
+ * Queue a byte of a frame and add it to the CRC, the space was checked
+ * @param byte byte to queue
+ * @param crc running CRC
+ * @return updated CRC
+ */
+static uint16_t capture_put(uint8_t byte, uint16_t crc) {
+    *(uint8_t *)ring_slot(&capture_ring) = byte;
+    ring_commit(&capture_ring);
+    return _crc_ccitt_update(crc, byte);
+}
+
+/**
+ * Send a sample as a frame, called from acquisition.c
+ * @param sample sample to send, PPG ones straight from the sensor
+ */
+void capture_sample(const acq_sample_t *sample) {
+    if (!capture_enabled) {
+        return;
+    }
+
+    uint8_t sequence = capture_sequence++;
+    uint8_t type = sample->type == ACQ_PPG ? CAPTURE_FRAME_PPG : CAPTURE_FRAME_EMG;
+    uint8_t payload = type == CAPTURE_FRAME_PPG ? CAPTURE_PPG_PAYLOAD : CAPTURE_EMG_PAYLOAD;
+    uint8_t length = CAPTURE_HEADER + payload + CAPTURE_TRAILER;
+
+    // Drop the whole frame if it does not fit, the gap in the sequence
+    // numbers shows up in the decoder
+    if (ring_space(&capture_ring) < length) {
+        return;
+    }
+
+    uint16_t crc = 0xFFFF;
+    capture_put(CAPTURE_SYNC1, crc);
+    capture_put(CAPTURE_SYNC2, crc);
+    crc = capture_put(sequence, crc);
+    crc = capture_put(type, crc);
+    crc = capture_put(sample->timestamp, crc);
+    crc = capture_put(sample->timestamp >> 8, crc);
+    crc = capture_put(sample->emg, crc);
+    crc = capture_put(sample->emg >> 8, crc);
+    if (type == CAPTURE_FRAME_PPG) {
+        crc = capture_put(sample->ir, crc);
+        crc = capture_put(sample->ir >> 8, crc);
+        crc = capture_put(sample->ir >> 16, crc);
+        crc = capture_put(sample->red, crc);
+        crc = capture_put(sample->red >> 8, crc);
+        crc = capture_put(sample->red >> 16, crc);
+    }
+    capture_put(crc, crc);
+    capture_put(crc >> 8, crc);
+
+    USART1.CTRLA |= USART_DREIE_bm;
+}
+
+/**
+ * USART1 data register empty interrupt, sends the next byte of the stream
+ */
+ISR(USART1_DRE_vect) {
+    const uint8_t *byte = ring_front(&capture_ring);
+    if (byte != NULL) {
+        USART1.TXDATAL = *byte;
+        ring_drop(&capture_ring);
+    } else {
+        USART1.CTRLA &= ~USART_DREIE_bm;
+    }
+}
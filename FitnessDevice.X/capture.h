@@ -0,0 +1,45 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bluetooth.h"
+#include "acquisition.h"
+#include "ring.h"
+
+#ifndef CAPTURE_H
+#define	CAPTURE_H
+
+// Raw samples are streamed out of USART1 (TX on PC0). At 250000 baud the
+// line carries 25000 bytes/s, the stream needs about 11400 (500 EMG frames of
+// 10 bytes and 400 PPG frames of 16 bytes per second). One decimated PPG
+// sample reads PPG_DECIMATION sensor samples at once, 64 bytes of frames.
+#define CAPTURE_BAUD 250000L
+
+// Size of the transmit buffer (power of two, at most 128)
+#define CAPTURE_BUFFER 128
+
+// Frame layout, all fields little endian:
+//   sync (2) | sequence (1) | type (1) | time (2) | payload | crc (2)
+// The CRC is CRC-16/CCITT (_crc_ccitt_update from 0xFFFF) over sequence to
+// the end of the payload, time is the low 16 bits of the sample's ms
+#define CAPTURE_SYNC1 0xA5
+#define CAPTURE_SYNC2 0x5A
+#define CAPTURE_HEADER 6
+#define CAPTURE_TRAILER 2
+
+// Frame types and their payloads
+// emg is the first muscle sensor only, the other channels are not streamed
+#define CAPTURE_FRAME_EMG 0x01 // emg (2)
+#define CAPTURE_FRAME_PPG 0x02 // emg (2) | ir (3) | red (3)
+#define CAPTURE_EMG_PAYLOAD 2
+#define CAPTURE_PPG_PAYLOAD 8
+
+void capture_init();
+void capture_enable(bool enable);
+bool capture_is_enabled();
+void capture_sample(const acq_sample_t *sample);
+ISR(USART1_DRE_vect);
+
+#endif	/* CAPTURE_H */
+
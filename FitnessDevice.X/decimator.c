@@ -0,0 +1,78 @@
+#include "decimator.h"
+/*
+ * Polyphase decimation of the high-rate PPG. A half-band filter has every
+ * other coefficient equal to zero apart from the center, and only every
+ * other output is kept, so each stage computes one output per two inputs
+ * with four multiplies thanks to the symmetry. Cascading two stages takes
+ * the sensor rate down by 4 while averaging away the sensor noise the
+ * dropped samples carried.
+ */
+
+/**
+ * Clear a decimator, the next sample fills its history
+ * @param dec decimator to clear
+ */
+void decimator_reset(decimator_t *dec) {
+    for (uint8_t s = 0; s < DECIMATOR_STAGES; s++) {
+        dec->stage[s].odd = false;
+    }
+    dec->primed = false;
+}
+
+/**
+ * Feed one sample into a half-band stage
+ * @param hb stage to feed
+ * @param in input sample
+ * @param out where to put the output
+ * @return true if an output was produced
+ */
+static bool halfband_push(halfband_t *hb, int32_t in, int32_t *out) {
+    for (uint8_t i = HALFBAND_TAPS - 1; i > 0; i--) {
+        hb->history[i] = hb->history[i - 1];
+    }
+    hb->history[0] = in;
+
+    // Only every other output is needed
+    hb->odd = !hb->odd;
+    if (hb->odd) {
+        return false;
+    }
+
+    const int32_t *x = hb->history;
+    int32_t acc = HALFBAND_C0 * x[5]
+            + HALFBAND_C1 * (x[4] + x[6])
+            + HALFBAND_C3 * (x[2] + x[8])
+            + HALFBAND_C5 * (x[0] + x[10]);
+    *out = (acc + (1L << (HALFBAND_SHIFT - 1))) >> HALFBAND_SHIFT;
+    return true;
+}
+
+/**
+ * Feed one high-rate sample into the decimator
+ * @param dec decimator to feed
+ * @param in input sample (18 bit sensor reading)
+ * @param out where to put the output
+ * @return true if an output was produced (every DECIMATOR_FACTOR inputs)
+ */
+bool decimator_push(decimator_t *dec, uint32_t in, uint32_t *out) {
+    // Start from the first sample instead of ringing up from zero
+    if (!dec->primed) {
+        for (uint8_t s = 0; s < DECIMATOR_STAGES; s++) {
+            for (uint8_t i = 0; i < HALFBAND_TAPS; i++) {
+                dec->stage[s].history[i] = in;
+            }
+        }
+        dec->primed = true;
+    }
+
+    int32_t value = in;
+    for (uint8_t s = 0; s < DECIMATOR_STAGES; s++) {
+        if (!halfband_push(&dec->stage[s], value, &value)) {
+            return false;
+        }
+    }
+
+    // The ripple of the filter can take a reading near zero slightly below
+    *out = value < 0 ? 0 : value;
+    return true;
+}
@@ -0,0 +1,40 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef DECIMATOR_H
+#define	DECIMATOR_H
+
+// Each stage is an 11 tap half-band lowpass that keeps every other output,
+// two stages take the sensor rate down by 4
+#define HALFBAND_TAPS 11
+#define DECIMATOR_STAGES 2
+#define DECIMATOR_FACTOR (1 << DECIMATOR_STAGES)
+
+// Half-band coefficients, the odd taps away from the center are zero and
+// they add up to 1 << HALFBAND_SHIFT
+#define HALFBAND_C0 256 // Center tap
+#define HALFBAND_C1 150 // Taps 1 away from the center
+#define HALFBAND_C3 -25 // Taps 3 away from the center
+#define HALFBAND_C5 3 // Taps 5 away from the center
+#define HALFBAND_SHIFT 9
+
+// Delay of the cascade in input samples, (taps - 1) / 2 at each stage's rate
+#define DECIMATOR_DELAY (((HALFBAND_TAPS - 1) / 2) * (DECIMATOR_FACTOR - 1))
+
+// Struct for one decimate by 2 stage
+typedef struct {
+    int32_t history[HALFBAND_TAPS]; // Newest input in history[0]
+    bool odd; // An input is waiting for its pair
+} halfband_t;
+
+// Struct for a decimate by DECIMATOR_FACTOR cascade
+typedef struct {
+    halfband_t stage[DECIMATOR_STAGES];
+    bool primed; // Histories hold real samples
+} decimator_t;
+
+void decimator_reset(decimator_t *dec);
+bool decimator_push(decimator_t *dec, uint32_t in, uint32_t *out);
+
+#endif	/* DECIMATOR_H */
+
@@ -0,0 +1,80 @@
+#include "diagnostics.h"
+#include "acquisition.h"
+#include "scratch.h"
+#include "max30102.h"
+#include "telemetry.h"
+#include "heart_rate.h"
+/*
+ * Stack watermarking: before main() runs, the RAM between the end of the
+ * globals and the top of the stack is painted with STACK_CANARY. The stack
+ * grows down into it, so the painted bytes left at the bottom tell how close
+ * the stack has ever come to the globals.
+ */
+
+// Symbols from the linker script, end of the globals and top of the stack
+extern uint8_t _end;
+extern uint8_t __stack;
+
+void diagnostics_paint_stack(void) __attribute__((naked, used, section(".init1")));
+
+/**
+ * Paint the free RAM with the canary, runs from .init1 before the stack
+ * pointer and the zero register are set up so it is written in assembly
+ */
+void diagnostics_paint_stack(void) {
+    __asm volatile (
+        "    ldi r30, lo8(_end)\n"
+        "    ldi r31, hi8(_end)\n"
+        "    ldi r24, %0\n"
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp 2f\n"
+        "1:\n"
+        "    st Z+, r24\n"
+        "2:\n"
+        "    cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25\n"
+        "    brlo 1b\n"
+        "    breq 1b\n"
+        :: "M" (STACK_CANARY)
+    );
+}
+
+/**
+ * Count the painted bytes the stack has never overwritten
+ * @return bytes of RAM never used by the stack
+ */
+uint16_t diagnostics_stack_unused() {
+    const uint8_t *p = &_end;
+    uint16_t count = 0;
+
+    while (p <= &__stack && *p == STACK_CANARY) {
+        p++;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Get the RAM taken by globals (.data and .bss)
+ * @return bytes of static RAM
+ */
+uint16_t diagnostics_static_ram() {
+    return &_end - (uint8_t *)INTERNAL_SRAM_START;
+}
+
+/**
+ * Fill a diagnostics record with the current values
+ * @param diag record to fill
+ */
+void diagnostics_collect(diagnostics_t *diag) {
+    diag->stack_unused = diagnostics_stack_unused();
+    diag->static_ram = diagnostics_static_ram();
+    diag->dropped_emg = acquisition_dropped_emg();
+    diag->dropped_ppg = acquisition_dropped_ppg();
+    diag->scratch_peak = scratch_peak();
+    diag->twi_failures = MAX30102_errors()->failures;
+    diag->twi_recoveries = MAX30102_errors()->recoveries;
+    diag->ppg_fifo_peak = acquisition_ppg_fifo_peak();
+    diag->telemetry_dropped = telemetry_dropped();
+    diag->heart_rate_dropped = heart_rate_dropped();
+}
@@ -0,0 +1,34 @@
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bluetooth.h"
+
+#ifndef DIAGNOSTICS_H
+#define	DIAGNOSTICS_H
+
+// Value the free RAM between the globals and the stack is filled with at
+// startup, bytes still holding it have never been used by the stack
+#define STACK_CANARY 0xC5
+
+// Record sent over the diagnostics characteristic, little endian
+typedef struct {
+    uint16_t stack_unused; // Bytes the stack has never reached
+    uint16_t static_ram; // Bytes used by globals
+    uint16_t dropped_emg; // EMG samples lost since startup
+    uint16_t dropped_ppg; // PPG samples lost since startup
+    uint16_t scratch_peak; // Most of the scratch arena ever in use
+    uint16_t twi_failures; // Sensor transactions that failed every retry
+    uint16_t twi_recoveries; // Sensor bus recoveries
+    uint16_t ppg_fifo_peak; // Fullest the sensor FIFO has been (32 is an overflow)
+    uint16_t telemetry_dropped; // Live snapshots coalesced or dropped
+    uint16_t heart_rate_dropped; // RR intervals lost before they were notified
+} diagnostics_t;
+
+typedef char diagnostics_size_check[sizeof(diagnostics_t) <= BLE_MAX_DATA ? 1 : -1];
+
+uint16_t diagnostics_stack_unused();
+uint16_t diagnostics_static_ram();
+void diagnostics_collect(diagnostics_t *diag);
+
+#endif	/* DIAGNOSTICS_H */
+
@@ -0,0 +1,152 @@
+#include "energy.h"
+#include "newavr-main.h"
+/*
+ * Energy accounting for the session. Nothing is measured electrically, the
+ * firmware counts how long each load has been on and a current model turns
+ * that into charge:
+ *  - time in each device state, covering the loads that only depend on it
+ *  - CPU awake against idle sleep, the main loop sleeps in energy_idle()
+ *    once it has handled everything and any interrupt wakes it (TCA0 runs
+ *    all the time, so at the latest after one PWM period). Interrupt
+ *    handlers that run while asleep count as sleep.
+ *  - LED and motor on-time weighted by duty, summed by the feedback ISR
+ *  - the MAX30102 LED current, from its pulse amplitudes and pulse width
+ * The counters cover the session since the last upload.
+ */
+
+// The counters are indexed by device_state
+typedef char energy_states_check[ENERGY_STATES == DEVICE_STATE_COUNT ? 1 : -1];
+
+// Feedback ticks per second, FX_TICK_RATE rounds the divider down so the
+// real rate is a little higher (about 101.7 Hz)
+#define ENERGY_FX_TICK_RATE ((float)FX_PWM_RATE / FX_TICK_DIVIDER)
+
+const energy_model_t energy_model = {
+    ENERGY_CPU_ACTIVE_UA,
+    ENERGY_CPU_SLEEP_UA,
+    ENERGY_LED_UA,
+    ENERGY_MOTOR_UA,
+    {ENERGY_BASE_UA, ENERGY_BASE_UA, ENERGY_BASE_UA, ENERGY_BASE_UA, ENERGY_TRANSMIT_UA},
+    ENERGY_BATTERY_MAH
+};
+
+// Milliseconds spent in each state, the current one up to energy_state_start
+uint32_t energy_state_ms[ENERGY_STATES] = {0};
+uint8_t energy_state = 0;
+uint32_t energy_state_start = 0;
+
+// Time asleep in RTC ticks (1/1024 s)
+uint32_t energy_sleep_ticks = 0;
+
+/**
+ * Add the time since the last call to the current state
+ */
+static void energy_flush() {
+    uint32_t now = millis();
+    energy_state_ms[energy_state] += now - energy_state_start;
+    energy_state_start = now;
+}
+
+/**
+ * Start the accounting and set up idle sleep
+ * @param state state the device starts in
+ */
+void energy_init(uint8_t state) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    energy_state = state;
+    energy_clear();
+}
+
+/**
+ * Charge the time so far to the state being left
+ * @param state state being entered
+ */
+void energy_set_state(uint8_t state) {
+    energy_flush();
+    if (state < ENERGY_STATES) {
+        energy_state = state;
+    }
+}
+
+/**
+ * Sleep until the next interrupt and count the time asleep
+ */
+void energy_idle() {
+    uint16_t start;
+    uint16_t end;
+
+    // 16-bit reads, kept clear of the interrupts that read the RTC too
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        start = RTC.CNT;
+    }
+    sleep_mode();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        end = RTC.CNT;
+    }
+    // The counter runs from 0 to 1023, one sleep is far shorter than a lap
+    energy_sleep_ticks += (end - start) & 0x3FF;
+}
+
+/**
+ * Turn the counters into a record for the app
+ * @param record filled with the totals since the last upload
+ */
+void energy_collect(energy_record_t *record) {
+    fx_usage_t usage;
+    float charge = 0; // uA * s
+    float total_s = 0;
+
+    energy_flush();
+    feedback_get_usage(&usage);
+
+    for (uint8_t i = 0; i < ENERGY_STATES; i++) {
+        float seconds = energy_state_ms[i] / 1000.0f;
+        total_s += seconds;
+        charge += seconds * energy_model.state[i];
+        record->state_time[i] = seconds > UINT16_MAX ? UINT16_MAX : (uint16_t)seconds;
+    }
+
+    float sleep_s = energy_sleep_ticks / 1024.0f;
+    if (sleep_s > total_s) {
+        sleep_s = total_s;
+    }
+    charge += (total_s - sleep_s) * energy_model.cpu_active + sleep_s * energy_model.cpu_sleep;
+    record->cpu_active = total_s > 0 ? (uint8_t)(100 * (total_s - sleep_s) / total_s + 0.5f) : 0;
+
+    // 255 per tick is fully on
+    float led_s = (float)(usage.led[0] + usage.led[1] + usage.led[2]) / (255.0f * ENERGY_FX_TICK_RATE);
+    float motor_s = (float)usage.motor / (255.0f * ENERGY_FX_TICK_RATE);
+    charge += led_s * energy_model.led + motor_s * energy_model.motor;
+    record->led_time = led_s > UINT16_MAX ? UINT16_MAX : (uint16_t)led_s;
+    record->motor_time = motor_s > UINT16_MAX ? UINT16_MAX : (uint16_t)motor_s;
+
+    // The sensor LEDs pulse from setup on
+    uint16_t ppg_ua = MAX30102_led_current();
+    charge += total_s * ppg_ua;
+    record->ppg_current = ppg_ua / 100 > UINT8_MAX ? UINT8_MAX : ppg_ua / 100;
+
+    // 1 mAh is 3600000 uA * s
+    float centi_mah = charge / 36000.0f;
+    record->charge = centi_mah > UINT16_MAX ? UINT16_MAX : (uint16_t)(centi_mah + 0.5f);
+
+    // Battery life at the session's average current
+    record->runtime = UINT16_MAX;
+    if (charge > 0) {
+        float minutes = energy_model.battery * 60000.0f * total_s / charge;
+        if (minutes < UINT16_MAX) {
+            record->runtime = minutes;
+        }
+    }
+}
+
+/**
+ * Start a new session from zero
+ */
+void energy_clear() {
+    for (uint8_t i = 0; i < ENERGY_STATES; i++) {
+        energy_state_ms[i] = 0;
+    }
+    energy_state_start = millis();
+    energy_sleep_ticks = 0;
+    feedback_clear_usage();
+}
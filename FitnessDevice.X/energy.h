@@ -0,0 +1,52 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bluetooth.h"
+
+#ifndef ENERGY_H
+#define	ENERGY_H
+
+// One time counter per device_state_t
+#define ENERGY_STATES 5
+
+// Current model in uA, datasheet figures at 3.3 V. The app cannot change
+// them, replace them here with figures measured on a board.
+#define ENERGY_CPU_ACTIVE_UA 3000 // ATmega3208 running at 10 MHz
+#define ENERGY_CPU_SLEEP_UA 1100 // Idle sleep, peripherals still clocked
+#define ENERGY_LED_UA 8000 // One LED color fully on
+#define ENERGY_MOTOR_UA 60000 // Vibration motor at full duty
+#define ENERGY_BASE_UA 3000 // RN4870 connected, muscle sensors, MAX30102 supply
+#define ENERGY_TRANSMIT_UA 8000 // As above with the radio sending
+#define ENERGY_BATTERY_MAH 500
+
+// Loads the accounting turns into charge, currents in uA
+typedef struct {
+    uint16_t cpu_active;
+    uint16_t cpu_sleep;
+    uint16_t led; // One LED color at full duty
+    uint16_t motor; // Motor at full duty
+    uint16_t state[ENERGY_STATES]; // Everything else drawn in each state
+    uint16_t battery; // Battery capacity in mAh
+} energy_model_t;
+
+// Record sent over the energy characteristic, little endian
+typedef struct {
+    uint16_t charge; // Estimated charge used in the session in 0.01 mAh
+    uint16_t runtime; // Minutes a full battery lasts at this average current
+    uint16_t state_time[ENERGY_STATES]; // Seconds spent in each state
+    uint8_t cpu_active; // Time the CPU was awake in percent
+    uint8_t ppg_current; // Average MAX30102 LED current in 0.1 mA
+    uint16_t led_time; // Seconds of LED light, all colors at full duty
+    uint16_t motor_time; // Seconds of the motor at full duty
+} energy_record_t;
+
+typedef char energy_record_size_check[sizeof(energy_record_t) <= BLE_MAX_DATA ? 1 : -1];
+
+void energy_init(uint8_t state);
+void energy_set_state(uint8_t state);
+void energy_idle();
+void energy_collect(energy_record_t *record);
+void energy_clear();
+
+#endif	/* ENERGY_H */
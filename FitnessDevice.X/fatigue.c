@@ -0,0 +1,237 @@
+#include "fatigue.h"
+/*
+ * Muscle fatigue from the spectrum of the EMG signal. As a muscle tires the
+ * power of its EMG moves to lower frequencies, so a falling median frequency
+ * over a set is the usual fatigue marker. This needs the raw (not enveloped)
+ * output of the muscle sensor on the first EMG channel.
+ *
+ * A bank of Goertzel filters runs over blocks of FATIGUE_BLOCK samples, one
+ * filter per bin from 15.6 Hz to 234 Hz. Each sample costs one 16 x 32 bit
+ * multiply per bin, well inside the time between samples at 500 sps. The
+ * bin powers of FATIGUE_WINDOW_BLOCKS blocks are summed into a window
+ * (Welch averaging), which gives the mean and median frequency of the
+ * window. Windows well above the resting power are contractions, a run of
+ * them is a rep, and the median frequency of every contraction window goes
+ * into a least squares line whose slope is the fatigue of the set.
+ */
+
+// 2cos(2 pi k / FATIGUE_BLOCK) in Q13 for bins 1 to FATIGUE_BINS
+const int16_t fatigue_coeffs[FATIGUE_BINS] = {
+    16069, 15137, 13623, 11585, 9102, 6270, 3196, 0,
+    -3196, -6270, -9102, -11585, -13623, -15137, -16069
+};
+
+// Goertzel state of the block being filtered
+int32_t fatigue_s1[FATIGUE_BINS] = {0};
+int32_t fatigue_s2[FATIGUE_BINS] = {0};
+uint8_t fatigue_block_count = 0;
+
+// Mean of the last block, removed from the samples of the next one so the
+// filter state stays small. A constant offset does not leak into bins 1-15.
+uint16_t fatigue_dc = 0;
+uint16_t fatigue_block_sum = 0;
+bool fatigue_started = false;
+
+// Bin powers summed over the window being collected
+uint32_t fatigue_power[FATIGUE_BINS] = {0};
+uint8_t fatigue_blocks = 0;
+
+// Power of a window at rest
+uint32_t fatigue_rest_power = 0;
+
+// Rep in progress
+uint8_t fatigue_rep_windows = 0;
+uint32_t fatigue_rep_mean_sum = 0;
+uint32_t fatigue_rep_median_sum = 0;
+
+// Least squares fit of the median frequency (0.1 Hz) against the window number
+uint16_t fatigue_window_index = 0;
+uint16_t fatigue_fit_count = 0;
+float fatigue_fit_t = 0;
+float fatigue_fit_y = 0;
+float fatigue_fit_tt = 0;
+float fatigue_fit_ty = 0;
+
+fatigue_t fatigue = {0};
+
+/**
+ * Turn a frequency in bins into 0.1 Hz
+ * @param bins frequency as a (fractional) bin number
+ * @return frequency in 0.1 Hz
+ */
+static uint16_t fatigue_to_freq(float bins) {
+    return bins * ((float)EMG_SAMPLE_RATE * 10 / FATIGUE_BLOCK) + 0.5f;
+}
+
+/**
+ * Works out the frequencies of a finished window and follows the reps
+ */
+static void fatigue_end_window() {
+    uint32_t total = 0;
+    float moment = 0;
+    for (uint8_t k = 0; k < FATIGUE_BINS; k++) {
+        total += fatigue_power[k];
+        moment += (float)fatigue_power[k] * (k + 1);
+    }
+
+    // Follow the quietest window, slowly letting the level rise again
+    if (fatigue_rest_power == 0 || total < fatigue_rest_power) {
+        fatigue_rest_power = total;
+    } else {
+        fatigue_rest_power += (fatigue_rest_power >> FATIGUE_REST_LEAK_SHIFT) + 1;
+    }
+    fatigue.active = total / FATIGUE_ACTIVE_RATIO > fatigue_rest_power;
+
+    if (total >= FATIGUE_BINS) {
+        // Median: where the cumulative power reaches half, taking the power
+        // of a bin as spread evenly over its width
+        uint32_t half = total / 2;
+        uint32_t cumulative = 0;
+        uint8_t k = 0;
+        while (cumulative + fatigue_power[k] < half) {
+            cumulative += fatigue_power[k];
+            k++;
+        }
+        float median = k + 0.5f + (float)(half - cumulative) / fatigue_power[k];
+
+        fatigue.mean = fatigue_to_freq(moment / total);
+        fatigue.median = fatigue_to_freq(median);
+    }
+
+    if (fatigue.active) {
+        if (fatigue_rep_windows < 255) {
+            fatigue_rep_windows++;
+            fatigue_rep_mean_sum += fatigue.mean;
+            fatigue_rep_median_sum += fatigue.median;
+        }
+
+        float t = fatigue_window_index;
+        fatigue_fit_count++;
+        fatigue_fit_t += t;
+        fatigue_fit_y += fatigue.median;
+        fatigue_fit_tt += t * t;
+        fatigue_fit_ty += t * fatigue.median;
+    } else if (fatigue_rep_windows > 0) {
+        // The contraction ended, short twitches are not reps
+        if (fatigue_rep_windows >= FATIGUE_REP_WINDOWS) {
+            fatigue.rep_mean = fatigue_rep_mean_sum / fatigue_rep_windows;
+            fatigue.rep_median = fatigue_rep_median_sum / fatigue_rep_windows;
+            if (fatigue.reps < 255) {
+                fatigue.reps++;
+            }
+        }
+        fatigue_rep_windows = 0;
+        fatigue_rep_mean_sum = 0;
+        fatigue_rep_median_sum = 0;
+    }
+    fatigue_window_index++;
+
+    for (uint8_t k = 0; k < FATIGUE_BINS; k++) {
+        fatigue_power[k] = 0;
+    }
+}
+
+/**
+ * Adds the power of the finished block to the window and restarts the filters
+ */
+static void fatigue_end_block() {
+    for (uint8_t k = 0; k < FATIGUE_BINS; k++) {
+        // |X(k)|^2 = s1^2 + s2^2 - coeff * s1 * s2, scaled down by 16 so
+        // every term fits 32 bits
+        int32_t a = fatigue_s1[k] >> 2;
+        int32_t b = fatigue_s2[k] >> 2;
+        int32_t p = a * a + b * b - (((int32_t)fatigue_coeffs[k] * a) >> 13) * b;
+        if (p > 0) {
+            fatigue_power[k] += p;
+        }
+        fatigue_s1[k] = 0;
+        fatigue_s2[k] = 0;
+    }
+
+    fatigue_dc = fatigue_block_sum / FATIGUE_BLOCK;
+    fatigue_block_sum = 0;
+    fatigue_block_count = 0;
+
+    if (++fatigue_blocks >= FATIGUE_WINDOW_BLOCKS) {
+        fatigue_blocks = 0;
+        fatigue_end_window();
+    }
+}
+
+/**
+ * Runs one muscle sensor reading through the filter bank
+ * @param emg_val raw reading of the first muscle sensor
+ */
+void fatigue_add(uint16_t emg_val) {
+    if (!fatigue_started) {
+        fatigue_dc = emg_val;
+        fatigue_started = true;
+    }
+
+    // |x| <= 511 bounds the state to 32 * 511 / sin(2 pi / 32), about 84000,
+    // so the Q13 product stays within 32 bits
+    int16_t x = (int16_t)emg_val - (int16_t)fatigue_dc;
+    if (x > FATIGUE_CLIP) {
+        x = FATIGUE_CLIP;
+    } else if (x < -FATIGUE_CLIP) {
+        x = -FATIGUE_CLIP;
+    }
+    fatigue_block_sum += emg_val;
+
+    for (uint8_t k = 0; k < FATIGUE_BINS; k++) {
+        int32_t s = x + ((fatigue_coeffs[k] * fatigue_s1[k]) >> 13) - fatigue_s2[k];
+        fatigue_s2[k] = fatigue_s1[k];
+        fatigue_s1[k] = s;
+    }
+
+    if (++fatigue_block_count >= FATIGUE_BLOCK) {
+        fatigue_end_block();
+    }
+}
+
+/**
+ * Get the spectral view of the set so far
+ * @return frequencies of the last window and rep and the fatigue slope
+ */
+const fatigue_t *fatigue_get() {
+    fatigue.slope = 0;
+    float den = fatigue_fit_count * fatigue_fit_tt - fatigue_fit_t * fatigue_fit_t;
+    if (fatigue_fit_count >= 2 && den > 0) {
+        // 0.1 Hz per window to 0.01 Hz per second
+        float slope = (fatigue_fit_count * fatigue_fit_ty - fatigue_fit_t * fatigue_fit_y) / den;
+        slope *= 10.0f * EMG_SAMPLE_RATE / ((uint16_t)FATIGUE_BLOCK * FATIGUE_WINDOW_BLOCKS);
+        if (slope > INT16_MAX) {
+            slope = INT16_MAX;
+        } else if (slope < INT16_MIN) {
+            slope = INT16_MIN;
+        }
+        fatigue.slope = slope;
+    }
+    return &fatigue;
+}
+
+/**
+ * Resets the filter bank and the set statistics
+ */
+void reset_fatigue_globals() {
+    for (uint8_t k = 0; k < FATIGUE_BINS; k++) {
+        fatigue_s1[k] = 0;
+        fatigue_s2[k] = 0;
+        fatigue_power[k] = 0;
+    }
+    fatigue_block_count = 0;
+    fatigue_block_sum = 0;
+    fatigue_started = false;
+    fatigue_blocks = 0;
+    fatigue_rest_power = 0;
+    fatigue_rep_windows = 0;
+    fatigue_rep_mean_sum = 0;
+    fatigue_rep_median_sum = 0;
+    fatigue_window_index = 0;
+    fatigue_fit_count = 0;
+    fatigue_fit_t = 0;
+    fatigue_fit_y = 0;
+    fatigue_fit_tt = 0;
+    fatigue_fit_ty = 0;
+    fatigue = (fatigue_t){0};
+}
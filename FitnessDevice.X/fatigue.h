@@ -0,0 +1,48 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "acquisition.h"
+
+#ifndef FATIGUE_H
+#define	FATIGUE_H
+
+// Goertzel block length in EMG samples, the bins are EMG_SAMPLE_RATE / 32
+// apart (15.6 Hz at 500 sps)
+#define FATIGUE_BLOCK 32
+
+// Bins 1 to 15 of the block, DC and the Nyquist bin are left out
+#define FATIGUE_BINS 15
+
+// Blocks whose power is summed into one window (256 samples, about 0.5 s)
+#define FATIGUE_WINDOW_BLOCKS 8
+
+// Deviation from the block mean a sample is clipped to, keeps the Goertzel
+// state within 32 bits
+#define FATIGUE_CLIP 511
+
+// A window is part of a contraction when its power is this many times the
+// resting level
+#define FATIGUE_ACTIVE_RATIO 4
+
+// Windows a contraction needs to be counted as a rep
+#define FATIGUE_REP_WINDOWS 2
+
+// The resting level follows the quietest window and creeps up by 1/32 per
+// window so a noisier electrode contact is picked up
+#define FATIGUE_REST_LEAK_SHIFT 5
+
+// Spectral view of the muscle signal, frequencies in 0.1 Hz
+typedef struct {
+    uint16_t mean; // Mean frequency of the last window
+    uint16_t median; // Median frequency of the last window
+    uint16_t rep_mean; // Mean frequency over the last finished rep
+    uint16_t rep_median; // Median frequency over the last finished rep
+    uint8_t reps; // Reps found in the set
+    bool active; // The last window was part of a contraction
+    int16_t slope; // Change of the median frequency over the set in 0.01 Hz/s
+} fatigue_t;
+
+void fatigue_add(uint16_t emg_val);
+const fatigue_t *fatigue_get();
+void reset_fatigue_globals();
+
+#endif	/* FATIGUE_H */
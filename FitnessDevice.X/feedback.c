@@ -0,0 +1,298 @@
+#include "feedback.h"
+#include <util/atomic.h>
+/*
+ * LED and vibration feedback driven by TCA0 in split mode. The motor on PA5
+ * is WO5 (high compare 2) so its PWM is generated by the timer alone. The
+ * LED pins are not on a TCA output, so they are switched off at the low
+ * timer underflow and back on at the low compare matches, which gives each
+ * color its own duty cycle. Patterns are stepped from the underflow interrupt
+ * so their timing does not depend on the main loop.
+ */
+
+// Color of the LED, 0 - 255 per channel
+volatile uint8_t led_color[3] = {0};
+
+// Players for the LED brightness and the motor level
+volatile fx_player_t led_player = {NULL, 0, 0, false, 255};
+volatile fx_player_t motor_player = {NULL, 0, 0, false, 0};
+
+// PWM periods since the last pattern step
+volatile uint8_t fx_divider = 0;
+
+// Duty of the outputs summed every tick, for the energy accounting
+volatile fx_usage_t fx_usage = {{0}, 0};
+
+// Built in patterns
+const fx_step_t fx_state_change[] = {
+    {255, FX_MS(500)},
+    {0, 0}
+};
+
+const fx_step_t fx_double_buzz[] = {
+    {255, FX_MS(150)},
+    {0, FX_MS(100)},
+    {255, FX_MS(150)},
+    {0, 0}
+};
+
+const fx_step_t fx_blink[] = {
+    {255, FX_MS(250)},
+    {0, FX_MS(250)},
+    {0, 0}
+};
+
+const fx_step_t fx_breathe[] = {
+    {16, FX_MS(100)}, {48, FX_MS(100)}, {96, FX_MS(100)}, {160, FX_MS(100)},
+    {255, FX_MS(200)},
+    {160, FX_MS(100)}, {96, FX_MS(100)}, {48, FX_MS(100)}, {16, FX_MS(100)},
+    {0, FX_MS(200)},
+    {0, 0}
+};
+
+/**
+ * Initialize TCA0 and the LED and motor pins
+ */
+void feedback_init() {
+    PORTD.DIRSET = PIN7_bm | PIN5_bm;
+    PORTA.DIRSET = PIN7_bm | PIN5_bm;
+    PORTD.OUTCLR = PIN7_bm | PIN5_bm;
+    PORTA.OUTCLR = PIN7_bm | PIN5_bm;
+
+    // Waveform outputs on port A, only WO5 (PA5) is ever enabled
+    PORTMUX.TCAROUTEA = PORTMUX_TCA0_PORTA_gc;
+
+    TCA0.SPLIT.CTRLD = TCA_SPLIT_SPLITM_bm;
+    TCA0.SPLIT.LPER = FX_PWM_TOP;
+    TCA0.SPLIT.HPER = FX_PWM_TOP;
+    TCA0.SPLIT.LCMP0 = 0;
+    TCA0.SPLIT.LCMP1 = 0;
+    TCA0.SPLIT.LCMP2 = 0;
+    TCA0.SPLIT.HCMP2 = 0;
+    TCA0.SPLIT.CTRLB = 0;
+    TCA0.SPLIT.INTCTRL = TCA_SPLIT_LUNF_bm;
+    TCA0.SPLIT.CTRLA = TCA_SPLIT_CLKSEL_DIV64_gc | TCA_SPLIT_ENABLE_bm;
+}
+
+/**
+ * Load the compare values for the current LED color and brightness
+ */
+static void feedback_apply_led() {
+    uint8_t intctrl = TCA_SPLIT_LUNF_bm;
+    uint8_t duty[3];
+
+    for (uint8_t i = 0; i < 3; i++) {
+        duty[i] = ((uint16_t)led_color[i] * (led_player.level + 1)) >> 8;
+        if (duty[i] > 0) {
+            intctrl |= TCA_SPLIT_LCMP0_bm << i;
+        }
+    }
+
+    TCA0.SPLIT.LCMP0 = duty[0];
+    TCA0.SPLIT.LCMP1 = duty[1];
+    TCA0.SPLIT.LCMP2 = duty[2];
+    TCA0.SPLIT.INTCTRL = intctrl;
+}
+
+/**
+ * Load the motor duty cycle, the output is disconnected when off
+ */
+static void feedback_apply_motor() {
+    if (motor_player.level > 0) {
+        TCA0.SPLIT.HCMP2 = motor_player.level;
+        TCA0.SPLIT.CTRLB = TCA_SPLIT_HCMP2EN_bm;
+    } else {
+        TCA0.SPLIT.CTRLB = 0;
+        PORTA.OUTCLR = PIN5_bm;
+    }
+}
+
+/**
+ * Start a pattern on a player
+ * @param player player to start
+ * @param pattern steps to play
+ * @param repeat true to loop the pattern
+ */
+static void feedback_start(volatile fx_player_t *player, const fx_step_t *pattern, bool repeat) {
+    if (pattern[0].duration == 0) {
+        return;
+    }
+    player->pattern = pattern;
+    player->index = 0;
+    player->remaining = pattern[0].duration;
+    player->repeat = repeat;
+    player->level = pattern[0].level;
+}
+
+/**
+ * Advance a player by one tick
+ * @param player player to advance
+ * @param idle_level level to go back to when the pattern ends
+ * @return true if the level changed
+ */
+static bool feedback_step(volatile fx_player_t *player, uint8_t idle_level) {
+    if (player->pattern == NULL) {
+        return false;
+    }
+    if (player->remaining > 0 && --player->remaining > 0) {
+        return false;
+    }
+
+    uint8_t old_level = player->level;
+    player->index++;
+    if (player->pattern[player->index].duration == 0) {
+        if (!player->repeat) {
+            player->pattern = NULL;
+            player->level = idle_level;
+            return old_level != idle_level;
+        }
+        player->index = 0;
+    }
+    player->remaining = player->pattern[player->index].duration;
+    player->level = player->pattern[player->index].level;
+    return old_level != player->level;
+}
+
+/**
+ * Set the LED color
+ * @param red red intensity, 0 - 255
+ * @param green green intensity, 0 - 255
+ * @param blue blue intensity, 0 - 255
+ */
+void feedback_set_color(uint8_t red, uint8_t green, uint8_t blue) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_color[0] = red;
+        led_color[1] = green;
+        led_color[2] = blue;
+        feedback_apply_led();
+    }
+}
+
+/**
+ * Set the LED brightness, stops any LED pattern
+ * @param level brightness, 0 - 255
+ */
+void feedback_set_brightness(uint8_t level) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        led_player.pattern = NULL;
+        led_player.level = level;
+        feedback_apply_led();
+    }
+}
+
+/**
+ * Play a brightness pattern on the LED with its current color
+ * @param pattern steps to play
+ * @param repeat true to loop the pattern
+ */
+void feedback_play_led(const fx_step_t *pattern, bool repeat) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        feedback_start(&led_player, pattern, repeat);
+        feedback_apply_led();
+    }
+}
+
+/**
+ * Play a pattern on the vibration motor
+ * @param pattern steps to play
+ * @param repeat true to loop the pattern
+ */
+void feedback_play_motor(const fx_step_t *pattern, bool repeat) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        feedback_start(&motor_player, pattern, repeat);
+        feedback_apply_motor();
+    }
+}
+
+/**
+ * Stop the vibration motor
+ */
+void feedback_stop_motor() {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        motor_player.pattern = NULL;
+        motor_player.level = 0;
+        feedback_apply_motor();
+    }
+}
+
+/**
+ * Check if the motor is playing a pattern
+ * @return true if a pattern is playing
+ */
+bool feedback_motor_busy() {
+    return motor_player.pattern != NULL;
+}
+
+/**
+ * Get how long the LED and the motor have been on
+ * @param usage filled with the duty weighted ticks since the last clear
+ */
+void feedback_get_usage(fx_usage_t *usage) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (uint8_t i = 0; i < 3; i++) {
+            usage->led[i] = fx_usage.led[i];
+        }
+        usage->motor = fx_usage.motor;
+    }
+}
+
+/**
+ * Start counting the LED and motor use from zero
+ */
+void feedback_clear_usage() {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (uint8_t i = 0; i < 3; i++) {
+            fx_usage.led[i] = 0;
+        }
+        fx_usage.motor = 0;
+    }
+}
+
+/**
+ * Start of a PWM period, turns the LEDs off and steps the patterns
+ */
+ISR(TCA0_LUNF_vect) {
+    PORTD.OUTCLR = PIN7_bm | PIN5_bm;
+    PORTA.OUTCLR = PIN7_bm;
+
+    if (++fx_divider >= FX_TICK_DIVIDER) {
+        fx_divider = 0;
+        if (feedback_step(&led_player, 255)) {
+            feedback_apply_led();
+        }
+        if (feedback_step(&motor_player, 0)) {
+            feedback_apply_motor();
+        }
+
+        // The compare values are the duty the LEDs are being driven at
+        fx_usage.led[0] += TCA0.SPLIT.LCMP0;
+        fx_usage.led[1] += TCA0.SPLIT.LCMP1;
+        fx_usage.led[2] += TCA0.SPLIT.LCMP2;
+        fx_usage.motor += motor_player.level;
+    }
+
+    TCA0.SPLIT.INTFLAGS = TCA_SPLIT_LUNF_bm;
+}
+
+/**
+ * Red duty cycle reached
+ */
+ISR(TCA0_LCMP0_vect) {
+    PORTD.OUTSET = PIN7_bm;
+    TCA0.SPLIT.INTFLAGS = TCA_SPLIT_LCMP0_bm;
+}
+
+/**
+ * Green duty cycle reached
+ */
+ISR(TCA0_LCMP1_vect) {
+    PORTD.OUTSET = PIN5_bm;
+    TCA0.SPLIT.INTFLAGS = TCA_SPLIT_LCMP1_bm;
+}
+
+/**
+ * Blue duty cycle reached
+ */
+ISR(TCA0_LCMP2_vect) {
+    PORTA.OUTSET = PIN7_bm;
+    TCA0.SPLIT.INTFLAGS = TCA_SPLIT_LCMP2_bm;
+}
@@ -0,0 +1,67 @@
+#ifndef F_CPU
+#define F_CPU 10000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FEEDBACK_H
+#define	FEEDBACK_H
+
+// TCA0 runs in split mode with both 8-bit halves counting from 0xFF,
+// F_CPU / 64 / 256 is about 600 Hz at 10 MHz
+#define FX_PWM_TOP 0xFF
+#define FX_PWM_RATE (F_CPU / 64 / (FX_PWM_TOP + 1))
+
+// Patterns step at about 100 Hz, counted in PWM periods
+#define FX_TICK_RATE 100
+#define FX_TICK_DIVIDER (FX_PWM_RATE / FX_TICK_RATE)
+#define FX_MS(ms) ((ms) / (1000 / FX_TICK_RATE))
+
+// Struct for one step of a pattern, a step with duration 0 ends it
+typedef struct {
+    uint8_t level; // Motor duty or LED brightness, 0 - 255
+    uint8_t duration; // Length of the step in ticks (see FX_MS)
+} fx_step_t;
+
+// Struct for a pattern being played on the LED or the motor
+typedef struct {
+    const fx_step_t *pattern; // NULL when nothing is playing
+    uint8_t index; // Current step
+    uint8_t remaining; // Ticks left in the current step
+    bool repeat; // Start over at the end instead of stopping
+    uint8_t level; // Level being output
+} fx_player_t;
+
+// Light and motor use since the last clear, counted in pattern ticks
+// weighted by duty (255 is one tick fully on)
+typedef struct {
+    uint32_t led[3]; // Red, green and blue
+    uint32_t motor;
+} fx_usage_t;
+
+// Built in patterns
+extern const fx_step_t fx_state_change[]; // Single 500 ms buzz
+extern const fx_step_t fx_double_buzz[]; // Two short buzzes
+extern const fx_step_t fx_blink[]; // LED on and off at 2 Hz
+extern const fx_step_t fx_breathe[]; // LED ramping up and down
+
+void feedback_init();
+void feedback_set_color(uint8_t red, uint8_t green, uint8_t blue);
+void feedback_set_brightness(uint8_t level);
+void feedback_play_led(const fx_step_t *pattern, bool repeat);
+void feedback_play_motor(const fx_step_t *pattern, bool repeat);
+void feedback_stop_motor();
+bool feedback_motor_busy();
+void feedback_get_usage(fx_usage_t *usage);
+void feedback_clear_usage();
+ISR(TCA0_LUNF_vect);
+ISR(TCA0_LCMP0_vect);
+ISR(TCA0_LCMP1_vect);
+ISR(TCA0_LCMP2_vect);
+
+#endif	/* FEEDBACK_H */
+
@@ -0,0 +1,35 @@
+// Generated by tools/fir_design.py, do not edit
+#include <stdint.h>
+
+#ifndef FIR_COEFFS_H
+#define	FIR_COEFFS_H
+
+// Q15 low-pass taps from the first tap to the center tap, the other half
+// mirrors them. FIR_BUFFER is the power of two history the filter keeps.
+#if PPG_SAMPLE_RATE == 50
+// 11 taps, -3 dB at 3.3 Hz
+#define FIR_TAPS 11
+#define FIR_BUFFER 16
+static const int16_t FIRCoeffs[6] = {
+    610, 1355, 3351, 5921, 8060, 8887
+};
+#elif PPG_SAMPLE_RATE == 100
+// 23 taps, -3 dB at 3.0 Hz
+#define FIR_TAPS 23
+#define FIR_BUFFER 32
+static const int16_t FIRCoeffs[12] = {
+    272, 346, 553, 886, 1325, 1839, 2385, 2919, 3394, 3768, 4007, 4093
+};
+#elif PPG_SAMPLE_RATE == 200
+// 45 taps, -3 dB at 3.1 Hz
+#define FIR_TAPS 45
+#define FIR_BUFFER 64
+static const int16_t FIRCoeffs[23] = {
+    136, 147, 174, 217, 277, 354, 444, 549, 665, 790, 922, 1058,
+    1196, 1332, 1464, 1588, 1702, 1803, 1889, 1959, 2009, 2040, 2051
+};
+#else
+#error "No FIR table for PPG_SAMPLE_RATE, add a profile to tools/fir_design.py"
+#endif
+
+#endif	/* FIR_COEFFS_H */
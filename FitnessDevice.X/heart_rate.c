@@ -0,0 +1,101 @@
+#include "heart_rate.h"
+#include "newavr-main.h"
+/*
+ * Standard Heart Rate Service (0x180D) for receivers like watches and gym
+ * equipment. Every beat hands its heart rate and RR interval over with
+ * heart_rate_beat(), which only updates a one-slot mailbox like the live
+ * telemetry. The RR intervals collect in the mailbox until heart_rate_task()
+ * finds the module idle and notifies them in one Heart Rate Measurement, so
+ * a busy link merges beats instead of losing their intervals, and nothing
+ * on the beat path waits for the USART. Past HR_MAX_RR the oldest interval
+ * is dropped.
+ */
+
+bool heart_rate_enabled = false;
+
+// Measurement waiting for the link
+uint8_t heart_rate_bpm = 0;
+uint16_t heart_rate_rr[HR_MAX_RR]; // RR intervals in 1/1024 s, oldest first
+uint8_t heart_rate_rr_count = 0;
+bool heart_rate_has_pending = false;
+uint32_t heart_rate_pending_time = 0; // Time of the oldest beat waiting
+uint16_t heart_rate_drops = 0;
+
+/**
+ * Start or stop the notifications, a measurement still waiting is dropped
+ * on stop
+ * @param enable true to notify beats
+ */
+void heart_rate_enable(bool enable) {
+    if (!enable) {
+        heart_rate_has_pending = false;
+        heart_rate_rr_count = 0;
+    }
+    heart_rate_enabled = enable;
+}
+
+/**
+ * Queue a beat for the next notification
+ * @param bpm heart rate to report
+ * @param interval_ms time since the beat before in ms
+ */
+void heart_rate_beat(uint8_t bpm, uint32_t interval_ms) {
+    if (!heart_rate_enabled) {
+        return;
+    }
+
+    if (!heart_rate_has_pending) {
+        heart_rate_pending_time = millis();
+    }
+    if (heart_rate_rr_count == HR_MAX_RR) {
+        for (uint8_t i = 1; i < HR_MAX_RR; i++) {
+            heart_rate_rr[i - 1] = heart_rate_rr[i];
+        }
+        heart_rate_rr_count--;
+        heart_rate_drops++;
+    }
+
+    uint32_t rr = (interval_ms * 1024 + 500) / 1000;
+    heart_rate_rr[heart_rate_rr_count++] = rr > UINT16_MAX ? UINT16_MAX : rr;
+    heart_rate_bpm = bpm;
+    heart_rate_has_pending = true;
+}
+
+/**
+ * Notify the waiting measurement once the module is free, call from the
+ * main loop
+ */
+void heart_rate_task() {
+    if (!heart_rate_has_pending) {
+        return;
+    }
+    if (millis() - heart_rate_pending_time >= HR_STALE_MS) {
+        heart_rate_has_pending = false;
+        heart_rate_drops += heart_rate_rr_count;
+        heart_rate_rr_count = 0;
+        return;
+    }
+
+    // Flags, the heart rate as uint8 and the RR intervals little endian
+    uint8_t data[2 + 2 * HR_MAX_RR];
+    uint8_t len = 0;
+    data[len++] = HR_FLAG_CONTACT_SUPPORTED | HR_FLAG_CONTACT_DETECTED | HR_FLAG_RR_PRESENT;
+    data[len++] = heart_rate_bpm;
+    for (uint8_t i = 0; i < heart_rate_rr_count; i++) {
+        data[len++] = heart_rate_rr[i];
+        data[len++] = heart_rate_rr[i] >> 8;
+    }
+
+    if (BLE_send_data(BLE_HEART_RATE_HANDLE, data, len)) {
+        heart_rate_has_pending = false;
+        heart_rate_rr_count = 0;
+    }
+}
+
+/**
+ * Get the number of RR intervals lost before they were sent
+ * @return dropped intervals since startup
+ */
+uint16_t heart_rate_dropped() {
+    return heart_rate_drops;
+}
@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "bluetooth.h"
+
+#ifndef HEART_RATE_H
+#define	HEART_RATE_H
+
+// Heart Rate Measurement flags (GATT 0x2A37)
+#define HR_FLAG_CONTACT_DETECTED 0x02
+#define HR_FLAG_CONTACT_SUPPORTED 0x04
+#define HR_FLAG_RR_PRESENT 0x10
+
+// RR intervals that fit in one notification after the flags and the
+// 8-bit heart rate
+#define HR_MAX_RR ((BLE_MAX_DATA - 2) / 2)
+
+// A measurement still unsent after this long is dropped instead of sent
+#define HR_STALE_MS 2000
+
+void heart_rate_enable(bool enable);
+void heart_rate_beat(uint8_t bpm, uint32_t interval_ms);
+void heart_rate_task();
+uint16_t heart_rate_dropped();
+
+#endif	/* HEART_RATE_H */
@@ -1,4 +1,21 @@
 #include "max30102.h"
+/*
+ * Every wait on the TWI is bounded by a per transaction budget, so a sensor
+ * that stops answering or a bus held low costs about
+ * MAX30102_WAIT_ESTIMATE_US instead of hanging the device. Failed
+ * transactions are retried, after a bus recovery if the bus itself was the
+ * problem, and counted.
+ */
+
+// Polls left before the current transaction times out
+uint16_t twi_budget = 0;
+
+// Error counters since startup
+twi_errors_t twi_errors = {0};
+
+// LED pulse amplitudes last written (0.2 mA per step)
+uint8_t led_amplitude_red = 0;
+uint8_t led_amplitude_ir = 0;
 
 /**
  * Function for applying bit mask to a register
@@ -7,7 +24,10 @@
  * @param value value that is being masked
  */
 void MAX30102_bitMask(uint8_t reg, uint8_t mask, uint8_t value) {
-    uint8_t currentValue = MAX30102_readRegister8(reg);
+    uint8_t currentValue;
+    if (!MAX30102_read_register(reg, &currentValue)) {
+        return; // Don't write back a value that was never read
+    }
     currentValue &= mask;
     currentValue |= value;
     MAX30102_writeRegister8(reg, currentValue);
@@ -15,13 +35,21 @@ void MAX30102_bitMask(uint8_t reg, uint8_t mask, uint8_t value) {
 
 /**
  * Soft reset the MAX30102
+ * @return true if the reset completed within MAX30102_RESET_TIMEOUT ms
  */
-void MAX30102_softReset() {
+bool MAX30102_softReset() {
     // Trigger soft reset
     MAX30102_bitMask(MAX30105_MODECONFIG, MAX30105_RESET_MASK, MAX30105_RESET);
 
     // Wait until the reset bit is cleared
-    while ((MAX30102_readRegister8(MAX30105_MODECONFIG) & MAX30105_RESET) != 0) {;}
+    for (uint8_t i = 0; i < MAX30102_RESET_TIMEOUT; i++) {
+        uint8_t mode;
+        if (MAX30102_read_register(MAX30105_MODECONFIG, &mode) && (mode & MAX30105_RESET) == 0) {
+            return true;
+        }
+        _delay_ms(1);
+    }
+    return false;
 }
 
 /**
@@ -32,20 +60,21 @@ void MAX30102_setup() {
     MAX30102_softReset();
 
     // Configure FIFO settings
-    MAX30102_bitMask(MAX30105_FIFOCONFIG, MAX30105_SAMPLEAVG_MASK, MAX30105_SAMPLEAVG_4); // Set sample average to 4 (default)
+    MAX30102_bitMask(MAX30105_FIFOCONFIG, MAX30105_SAMPLEAVG_MASK, MAX30105_SAMPLEAVG_1); // No averaging, done by the acquisition
     MAX30102_bitMask(MAX30105_FIFOCONFIG, MAX30105_ROLLOVER_MASK, MAX30105_ROLLOVER_ENABLE); // Enable FIFO rollover
 
-    // Configure mode
-    MAX30102_bitMask(MAX30105_MODECONFIG, MAX30105_MODE_MASK, MAX30105_MODE_MULTILED); // Set to Multi-LED mode (default)
+    // Configure mode, the MAX30102 only has red and IR LEDs so SpO2 mode keeps
+    // the FIFO to two channels
+    MAX30102_bitMask(MAX30105_MODECONFIG, MAX30105_MODE_MASK, MAX30105_MODE_REDIRONLY);
     
     // ADC 62.5pA per LSB
     MAX30102_bitMask(MAX30105_PARTICLECONFIG, MAX30105_ADCRANGE_MASK, MAX30105_ADCRANGE_4096);
 
-    // Set sample rate
-    MAX30102_bitMask(MAX30105_PARTICLECONFIG, MAX30105_SAMPLERATE_MASK, MAX30105_SAMPLERATE_100);
+    // Set sample rate to PPG_SENSOR_RATE
+    MAX30102_bitMask(MAX30105_PARTICLECONFIG, MAX30105_SAMPLERATE_MASK, PPG_SENSOR_RATE_CONFIG);
     
-    // Set pulse width to 69us (default)
-    MAX30102_bitMask(MAX30105_PARTICLECONFIG, MAX30105_PULSEWIDTH_MASK, MAX30105_PULSEWIDTH_411);
+    // Set the longest pulse width the sample rate allows
+    MAX30102_bitMask(MAX30105_PARTICLECONFIG, MAX30105_PULSEWIDTH_MASK, PPG_PULSE_WIDTH);
 
     // Configure LED pulse amplitudes
     
@@ -60,13 +89,36 @@ void MAX30102_setup() {
     MAX30102_bitMask(MAX30105_MULTILEDCONFIG2, MAX30105_SLOT3_MASK, SLOT_GREEN_LED);
 
     // Clear FIFO
-    MAX30102_writeRegister8(MAX30105_FIFOWRITEPTR, 0x00); // FIFO Write Pointer
-    MAX30102_writeRegister8(MAX30105_FIFOOVERFLOW, 0x00); // FIFO Read Pointer
-    MAX30102_writeRegister8(MAX30105_FIFOREADPTR, 0x00); // FIFO Overflow Counter
+    MAX30102_clearFIFO();
     
     // For HR
     MAX30102_writeRegister8(MAX30105_LED1_PULSEAMP, 0x0A); // Red LED
     MAX30102_writeRegister8(MAX30105_LED3_PULSEAMP, 0); // Green LED
+    led_amplitude_red = 0x0A;
+    led_amplitude_ir = DEFAULT_POWER_LEVEL;
+}
+
+/**
+ * Set the LED pulse amplitudes (0.2 mA per step)
+ * @param red red LED amplitude
+ * @param ir IR LED amplitude
+ */
+void MAX30102_set_led_amplitudes(uint8_t red, uint8_t ir) {
+    MAX30102_writeRegister8(MAX30105_LED1_PULSEAMP, red); // Red LED
+    MAX30102_writeRegister8(MAX30105_LED2_PULSEAMP, ir); // IR LED
+    led_amplitude_red = red;
+    led_amplitude_ir = ir;
+}
+
+/**
+ * Get the average current of the sensor LEDs, which pulse at PPG_SENSOR_RATE
+ * from setup on whether or not the samples are read
+ * @return average LED current in uA
+ */
+uint16_t MAX30102_led_current() {
+    // 200 uA per step for PPG_PULSE_US out of every sample period
+    uint32_t pulse_ua = ((uint32_t)led_amplitude_red + led_amplitude_ir) * 200;
+    return pulse_ua * PPG_PULSE_US / PPG_SENSOR_PERIOD_US;
 }
 
 /**
@@ -79,185 +131,294 @@ void MAX30102_init() {
     // Enable pullup resistors
     PORTA.PIN2CTRL |= PORT_PULLUPEN_bm;
     PORTA.PIN3CTRL |= PORT_PULLUPEN_bm;
-    // Baud rate for 100kHz
-    TWI0.MBAUD = 11;
-    TWI0.MCTRLA = TWI_ENABLE_bm;
-    TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;     
+    // Baud rate for TWI_FREQUENCY
+    TWI0.MBAUD = TWI_BAUD(TWI_FREQUENCY);
+    // The bus timeout lets the bus state go back to idle if a STOP is missed
+    TWI0.MCTRLA = TWI_ENABLE_bm | TWI_TIMEOUT_200US_gc;
+    TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
 }
 
 /**
- * Request data from the circular buffer on the MAX30102
- * @param toGet
- * @param buffer
+ * Wait for a TWI status flag, giving up when the transaction budget runs out
+ * @param flags status flags to wait on
+ * @return TWI_OK, TWI_ERR_TIMEOUT or TWI_ERR_BUS
  */
-void MAX30102_buffer_data(uint8_t toGet, uint8_t *buffer) {
-    // Step 1: Send START condition and write address to set register pointer
-    TWI0.MADDR = (MAX30102_I2C_ADDR << 1) | 0; // Address with WRITE bit
-
-    // Wait for acknowledgment
-    while (!(TWI0.MSTATUS & TWI_WIF_bm));
-
-    // Write the register address
-    TWI0.MDATA = MAX30105_FIFODATA; // Specify the FIFO data register
-    while (!(TWI0.MSTATUS & TWI_WIF_bm)); // Wait for acknowledgment
-
-    // Step 2: Send repeated START and switch to READ mode
-    TWI0.MCTRLB = TWI_MCMD_REPSTART_gc; // Send repeated START
-    TWI0.MADDR = (MAX30102_I2C_ADDR << 1) | 1; // Address with READ bit
-
-    // Wait for acknowledgment
-    while (!(TWI0.MSTATUS & TWI_RIF_bm));
+static twi_status_t twi_wait(uint8_t flags) {
+    while (!(TWI0.MSTATUS & flags)) {
+        if (twi_budget == 0) {
+            return TWI_ERR_TIMEOUT;
+        }
+        twi_budget--;
+        _delay_us(TWI_POLL_US);
+    }
+    if (TWI0.MSTATUS & (TWI_BUSERR_bm | TWI_ARBLOST_bm)) {
+        return TWI_ERR_BUS;
+    }
+    return TWI_OK;
+}
 
-    // Step 3: Read data into the buffer
-    for (uint8_t i = 0; i < toGet; i++) {
-        // Wait for data reception
-        while (!(TWI0.MSTATUS & TWI_RIF_bm));
-        buffer[i] = TWI0.MDATA; // Read data into buffer
+/**
+ * Send a START (or repeated START) and the address
+ * @param address address with the read/write bit
+ * @return TWI_OK, or why the address was not acknowledged
+ */
+static twi_status_t twi_start(uint8_t address) {
+    TWI0.MADDR = address;
+    twi_status_t status = twi_wait(TWI_WIF_bm | TWI_RIF_bm);
+    if (status == TWI_OK && (TWI0.MSTATUS & TWI_WIF_bm) && (TWI0.MSTATUS & TWI_RXACK_bm)) {
+        status = TWI_ERR_NACK;
+    }
+    return status;
+}
 
-        // Acknowledge or NACK the data
-        if (i == toGet - 1) {
-            TWI0.MCTRLB = TWI_ACKACT_bm | TWI_MCMD_STOP_gc; // Send NACK and STOP on last byte
-        } else {
-            TWI0.MCTRLB = TWI_MCMD_RECVTRANS_gc; // Send ACK to continue receiving
-        }
+/**
+ * Send one byte to the device
+ * @param data byte to send
+ * @return TWI_OK, or why the byte was not acknowledged
+ */
+static twi_status_t twi_write_byte(uint8_t data) {
+    TWI0.MDATA = data;
+    twi_status_t status = twi_wait(TWI_WIF_bm);
+    if (status == TWI_OK && (TWI0.MSTATUS & TWI_RXACK_bm)) {
+        status = TWI_ERR_NACK;
     }
+    return status;
 }
 
 /**
- * Read from a register on the MAX30102
- * @param reg The register to read from
- * @return 
+ * Write to or read from consecutive registers, one attempt
+ * @param reg first register
+ * @param buffer bytes to write or where to put the bytes read
+ * @param len number of bytes
+ * @param read true to read, false to write
+ * @return TWI_OK or the error that ended the transaction
  */
-uint8_t MAX30102_readRegister8(uint8_t reg) {
-    // Ensure bus is idle
+static twi_status_t twi_transaction(uint8_t reg, uint8_t *buffer, uint8_t len, bool read) {
+    // A bus left in an unknown state after an error is taken as idle
     if ((TWI0.MSTATUS & TWI_BUSSTATE_gm) != TWI_BUSSTATE_IDLE_gc) {
-        TWI0.MCTRLB = TWI_MCMD_STOP_gc; // Send STOP to reset bus
-        TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc; // Force bus to idle
+        TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
     }
 
-    // Send START condition and slave address with write bit
-    TWI0.MADDR = (MAX30102_I2C_ADDR << 1); // Write operation
-    while (!(TWI0.MSTATUS & (TWI_WIF_bm | TWI_RIF_bm)));
+    twi_status_t status = twi_start(MAX30102_I2C_ADDR << 1);
+    if (status == TWI_OK) {
+        status = twi_write_byte(reg);
+    }
 
-    if (TWI0.MSTATUS & TWI_RXACK_bm) {
+    if (!read) {
+        for (uint8_t i = 0; i < len && status == TWI_OK; i++) {
+            status = twi_write_byte(buffer[i]);
+        }
         TWI0.MCTRLB = TWI_MCMD_STOP_gc;
-        return 0xFF; // NACK received
+        return status;
     }
 
-    // Send register address
-    TWI0.MDATA = reg;
-    while (!(TWI0.MSTATUS & TWI_WIF_bm));
-    if (TWI0.MSTATUS & TWI_RXACK_bm) {
-        TWI0.MCTRLB = TWI_MCMD_STOP_gc;
-        return 0xFF; // NACK received
+    // Writing the address with the read bit sends a repeated START
+    if (status == TWI_OK) {
+        status = twi_start((MAX30102_I2C_ADDR << 1) | 1);
     }
+    for (uint8_t i = 0; i < len && status == TWI_OK; i++) {
+        status = twi_wait(TWI_RIF_bm);
+        if (status != TWI_OK) {
+            break;
+        }
+        buffer[i] = TWI0.MDATA;
 
-    // Send repeated START condition and slave address with read bit
-    TWI0.MADDR = (MAX30102_I2C_ADDR << 1) | 1; // Read operation
-    while (!(TWI0.MSTATUS & (TWI_WIF_bm | TWI_RIF_bm)));
-    if (TWI0.MSTATUS & TWI_RXACK_bm) {
+        // ACK to keep receiving, NACK and STOP after the last byte
+        if (i == len - 1) {
+            TWI0.MCTRLB = TWI_ACKACT_bm | TWI_MCMD_STOP_gc;
+        } else {
+            TWI0.MCTRLB = TWI_MCMD_RECVTRANS_gc;
+        }
+    }
+    if (status != TWI_OK) {
         TWI0.MCTRLB = TWI_MCMD_STOP_gc;
-        return 0xFF; // NACK received
     }
+    return status;
+}
 
-    // Read data
-    while (!(TWI0.MSTATUS & TWI_RIF_bm));
-    uint8_t data = TWI0.MDATA;
-
-    // Send NACK and STOP condition
-    TWI0.MCTRLB = TWI_ACKACT_bm | TWI_MCMD_STOP_gc;
+/**
+ * Free a bus held by a device stuck in the middle of a byte: clock SCL until
+ * the device lets go of SDA (at most 9 clocks), then send a STOP
+ */
+static void twi_bus_recover() {
+    twi_errors.recoveries++;
+
+    // Take the pins over from the TWI, they are pulled up and only ever
+    // driven low so they act as open drain
+    TWI0.MCTRLA = 0;
+    PORTA.OUTCLR = PIN2_bm | PIN3_bm;
+    PORTA.DIRCLR = PIN2_bm | PIN3_bm;
+    _delay_us(TWI_RECOVERY_HALF_US);
+
+    for (uint8_t i = 0; i < 9 && !(PORTA.IN & PIN2_bm); i++) {
+        PORTA.DIRSET = PIN3_bm; // SCL low
+        _delay_us(TWI_RECOVERY_HALF_US);
+        PORTA.DIRCLR = PIN3_bm; // SCL high
+        _delay_us(TWI_RECOVERY_HALF_US);
+    }
 
-    return data;
+    // STOP, SDA rising while SCL is high
+    PORTA.DIRSET = PIN3_bm;
+    PORTA.DIRSET = PIN2_bm;
+    _delay_us(TWI_RECOVERY_HALF_US);
+    PORTA.DIRCLR = PIN3_bm;
+    _delay_us(TWI_RECOVERY_HALF_US);
+    PORTA.DIRCLR = PIN2_bm;
+    _delay_us(TWI_RECOVERY_HALF_US);
+
+    // Give the pins back to the TWI. It has to own them before they are made
+    // outputs, with OUT cleared they would otherwise pull both lines low.
+    TWI0.MCTRLA = TWI_ENABLE_bm | TWI_TIMEOUT_200US_gc;
+    TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
+    PORTA.DIRSET = PIN2_bm | PIN3_bm;
 }
 
 /**
- * Write to a register on the MAX30102
- * @param reg
- * @param value
+ * Run a transaction, retrying on errors and recovering the bus after
+ * timeouts and bus errors. Takes about MAX30102_WAIT_ESTIMATE_US at most.
+ * @param reg first register
+ * @param buffer bytes to write or where to put the bytes read
+ * @param len number of bytes
+ * @param read true to read, false to write
+ * @return true if the transaction went through
  */
-void MAX30102_writeRegister8(uint8_t reg, uint8_t value) {
-    // Ensure bus is idle
-    if ((TWI0.MSTATUS & TWI_BUSSTATE_gm) != TWI_BUSSTATE_IDLE_gc) {
-        TWI0.MCTRLB = TWI_MCMD_STOP_gc; // Send STOP to reset bus
-        TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc; // Force bus to idle
+static bool twi_transfer(uint8_t reg, uint8_t *buffer, uint8_t len, bool read) {
+    for (uint8_t attempt = 0; attempt < TWI_ATTEMPTS; attempt++) {
+        twi_budget = TWI_TRANSACTION_POLLS;
+        twi_status_t status = twi_transaction(reg, buffer, len, read);
+
+        switch (status) {
+            case TWI_OK:
+                return true;
+            case TWI_ERR_NACK:
+                twi_errors.nacks++;
+                break;
+            case TWI_ERR_TIMEOUT:
+                twi_errors.timeouts++;
+                twi_bus_recover();
+                break;
+            case TWI_ERR_BUS:
+                twi_errors.bus_errors++;
+                twi_bus_recover();
+                break;
+        }
     }
+    twi_errors.failures++;
+    return false;
+}
 
-    // Send START condition and slave address with write bit
-    TWI0.MADDR = (MAX30102_I2C_ADDR << 1); // Write operation
-    while (!(TWI0.MSTATUS & TWI_WIF_bm));
+/**
+ * Request data from the circular buffer on the MAX30102
+ * @param toGet number of bytes to read
+ * @param buffer where to put the bytes
+ * @return true if the bytes were read
+ */
+bool MAX30102_buffer_data(uint8_t toGet, uint8_t *buffer) {
+    return twi_transfer(MAX30105_FIFODATA, buffer, toGet, true);
+}
 
-    if (TWI0.MSTATUS & TWI_RXACK_bm) {
-        TWI0.MCTRLB = TWI_MCMD_STOP_gc;
-        return; // NACK received
+/**
+ * Read from a register on the MAX30102
+ * @param reg the register to read from
+ * @param value where to put the value
+ * @return true if the register was read
+ */
+bool MAX30102_read_register(uint8_t reg, uint8_t *value) {
+    return twi_transfer(reg, value, 1, true);
+}
+
+/**
+ * Read from a register on the MAX30102
+ * @param reg The register to read from
+ * @return value of the register, 0xFF if it could not be read
+ */
+uint8_t MAX30102_readRegister8(uint8_t reg) {
+    uint8_t value;
+    if (!MAX30102_read_register(reg, &value)) {
+        return 0xFF;
     }
+    return value;
+}
 
-    // Send register address
-    TWI0.MDATA = reg;
-    while (!(TWI0.MSTATUS & TWI_WIF_bm));
+/**
+ * Write to a register on the MAX30102
+ * @param reg register to write
+ * @param value value to write
+ * @return true if the register was written
+ */
+bool MAX30102_writeRegister8(uint8_t reg, uint8_t value) {
+    return twi_transfer(reg, &value, 1, false);
+}
 
-    if (TWI0.MSTATUS & TWI_RXACK_bm) {
-        TWI0.MCTRLB = TWI_MCMD_STOP_gc;
-        return; // NACK received
-    }
+/**
+ * Get the counts of TWI errors since startup
+ * @return error counters
+ */
+const twi_errors_t *MAX30102_errors() {
+    return &twi_errors;
+}
 
-    // Send data
-    TWI0.MDATA = value;
-    while (!(TWI0.MSTATUS & TWI_WIF_bm));
+/**
+ * Get a sample of ir and red values from the MAX30102
+ * @param sample
+ * @return true if the sample was read
+ */
+bool MAX30102_get_sample(MAX30102_sample_t *sample) {
+    uint8_t buffer[MAX30102_SAMPLE_BYTES];
 
-    if (TWI0.MSTATUS & TWI_RXACK_bm) {
-        TWI0.MCTRLB = TWI_MCMD_STOP_gc;
-        return; // NACK received
+    // Read one sample into buffer
+    if (!MAX30102_buffer_data(MAX30102_SAMPLE_BYTES, buffer)) {
+        return false;
     }
-
-    // Send STOP condition
-    TWI0.MCTRLB = TWI_MCMD_STOP_gc;
+    MAX30102_decode_sample(buffer, sample);
+    return true;
 }
 
 /**
- * Get a sample of ir, red, and green values from the MAX30102
- * @param sample
+ * Turn the bytes of one FIFO sample into red and IR values, used for samples
+ * read in a burst
+ * @param buffer MAX30102_SAMPLE_BYTES bytes read from the FIFO
+ * @param sample where to put the values
  */
-void MAX30102_get_sample(MAX30102_sample_t *sample) {
-    volatile uint8_t buffer[9];
-    volatile uint32_t tempLong;
-    volatile uint8_t temp[4];
-
-    // Read 9 bytes into buffer
-    MAX30102_buffer_data(9, buffer);
-
-    // Combine the 3 bytes into a single 32-bit value for red LED
-    temp[3] = 0;
-    temp[2] = buffer[0];
-    temp[1] = buffer[1];
-    temp[0] = buffer[2];
-    memcpy(&tempLong, temp, sizeof(tempLong));
-    tempLong &= 0x3FFFF; // Mask to 18 bits
-    sample->red = tempLong;
-    
-    // Combine the 3 bytes into a single 32-bit value for IR LED
-    temp[3] = 0;
-    temp[2] = buffer[3];
-    temp[1] = buffer[4];
-    temp[0] = buffer[5];
-    memcpy(&tempLong, temp, sizeof(tempLong));
-    tempLong &= 0x3FFFF; // Mask to 18 bits
-    sample->ir = tempLong;
-    
-    // Combine the 3 bytes into a single 32-bit value for green LED
-    temp[3] = 0;
-    temp[2] = buffer[6];
-    temp[1] = buffer[7];
-    temp[0] = buffer[8];
-    memcpy(&tempLong, temp, sizeof(tempLong));
-    tempLong &= 0x3FFFF; // Mask to 18 bits
-    sample->green = tempLong;
+void MAX30102_decode_sample(const uint8_t *buffer, MAX30102_sample_t *sample) {
+    // Each value is 3 bytes, most significant first, masked to 18 bits
+    sample->red = (((uint32_t)buffer[0] << 16) | ((uint16_t)buffer[1] << 8) | buffer[2]) & 0x3FFFF;
+    sample->ir = (((uint32_t)buffer[3] << 16) | ((uint16_t)buffer[4] << 8) | buffer[5]) & 0x3FFFF;
+
+    // No green LED on the MAX30102
+    sample->green = 0;
 }
 
 /**
  * Reset the circular buffer and clear it on the MAX30102
  */
 void MAX30102_clearFIFO() {
-    MAX30102_writeRegister8(0x04, 0x00); // FIFO Write Pointer
-    MAX30102_writeRegister8(0x05, 0x00); // FIFO Read Pointer
-    MAX30102_writeRegister8(0x06, 0x00); // FIFO Overflow Counter
+    MAX30102_writeRegister8(MAX30105_FIFOWRITEPTR, 0x00); // FIFO Write Pointer
+    MAX30102_writeRegister8(MAX30105_FIFOOVERFLOW, 0x00); // FIFO Overflow Counter
+    MAX30102_writeRegister8(MAX30105_FIFOREADPTR, 0x00); // FIFO Read Pointer
+}
+
+/**
+ * Get the number of samples waiting in the FIFO
+ * @return number of unread samples (0 to 31)
+ */
+uint8_t MAX30102_available() {
+    uint8_t write_ptr, read_ptr;
+    if (!MAX30102_read_register(MAX30105_FIFOWRITEPTR, &write_ptr)
+            || !MAX30102_read_register(MAX30105_FIFOREADPTR, &read_ptr)) {
+        return 0;
+    }
+    return (write_ptr - read_ptr) & 0x1F;
+}
+
+/**
+ * Get the number of samples lost since the FIFO was last read
+ * @return overflow counter (saturates at 31)
+ */
+uint8_t MAX30102_overflow() {
+    uint8_t overflow;
+    if (!MAX30102_read_register(MAX30105_FIFOOVERFLOW, &overflow)) {
+        return 0;
+    }
+    return overflow & 0x1F;
 }
\ No newline at end of file
@@ -1,5 +1,5 @@
 #ifndef F_CPU
-#define F_CPU 3333333
+#define F_CPU 10000000
 #endif
 
 #include <avr/io.h>
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <avr/interrupt.h>
 #include "max30102_math.h"
 
@@ -143,8 +144,82 @@
 
 #define MAX30105_EXPECTEDPARTID 0x15
 
-// Size of buffer for storing samples
-#define RATE_SIZE 4
+// Time between sensor samples, PPG_SENSOR_RATE is in max30102_math.h
+#define PPG_SENSOR_PERIOD_US (1000000L / PPG_SENSOR_RATE)
+
+// Sample rate and LED pulse width for PPG_SENSOR_RATE. In SpO2 mode 411us
+// pulses (18 bit) fit up to 400 sps, 800 sps needs 215us (17 bit).
+#if PPG_SENSOR_RATE == 200
+#define PPG_SENSOR_RATE_CONFIG MAX30105_SAMPLERATE_200
+#define PPG_PULSE_WIDTH MAX30105_PULSEWIDTH_411
+#define PPG_PULSE_US 411
+#elif PPG_SENSOR_RATE == 400
+#define PPG_SENSOR_RATE_CONFIG MAX30105_SAMPLERATE_400
+#define PPG_PULSE_WIDTH MAX30105_PULSEWIDTH_411
+#define PPG_PULSE_US 411
+#elif PPG_SENSOR_RATE == 800
+#define PPG_SENSOR_RATE_CONFIG MAX30105_SAMPLERATE_800
+#define PPG_PULSE_WIDTH MAX30105_PULSEWIDTH_215
+#define PPG_PULSE_US 215
+#else
+#error "Unsupported PPG_SENSOR_RATE"
+#endif
+
+// Samples read from the FIFO in one TWI transaction
+#define MAX30102_BURST 8
+
+// Fast-mode TWI, BAUD = F_CPU / (2 * f) - (5 + F_CPU * t_rise / 2)
+#define TWI_FREQUENCY 400000L
+#define TWI_RISE_TIME_NS 300L
+#define TWI_BAUD(f) (F_CPU / (2 * (f)) - 5 - (F_CPU / 1000 * TWI_RISE_TIME_NS) / 2000000)
+#if TWI_BAUD(TWI_FREQUENCY) < 0
+#error "F_CPU is too low for TWI_FREQUENCY"
+#endif
+
+// Bytes per FIFO sample in SpO2 mode (3 bytes each for red and IR)
+#define MAX30102_SAMPLE_BYTES 6
+
+// TWI timing. Each attempt at a transaction gets TWI_TRANSACTION_POLLS polls
+// TWI_POLL_US apart to finish, and a failed attempt is followed by a bus
+// recovery of up to TWI_RECOVERY_HALF_PERIODS half clocks (one to release
+// the pins, 9 clocks and 3 for the STOP)
+#define TWI_POLL_US 2
+#define TWI_TRANSACTION_US 2000
+#define TWI_TRANSACTION_POLLS (TWI_TRANSACTION_US / TWI_POLL_US)
+#define TWI_RECOVERY_HALF_US 5
+#define TWI_RECOVERY_HALF_PERIODS (1 + 2 * 9 + 3)
+#define TWI_ATTEMPTS 3
+
+// The polling loop around each _delay_us(TWI_POLL_US), about 10 cycles at
+// 10 MHz
+#define TWI_POLL_OVERHEAD_US 1
+
+// Estimate of the longest a single register access or FIFO read blocks,
+// about 9.3 ms. The budget counts polls, not time, so interrupts that run
+// during the wait come on top.
+#define MAX30102_WAIT_ESTIMATE_US (TWI_ATTEMPTS \
+    * ((uint32_t)TWI_TRANSACTION_POLLS * (TWI_POLL_US + TWI_POLL_OVERHEAD_US) \
+    + TWI_RECOVERY_HALF_PERIODS * TWI_RECOVERY_HALF_US))
+
+// Longest wait in ms for a soft reset to complete
+#define MAX30102_RESET_TIMEOUT 50
+
+// Outcome of a TWI transaction
+typedef enum {
+    TWI_OK,
+    TWI_ERR_NACK, // Device did not acknowledge
+    TWI_ERR_TIMEOUT, // Transaction ran out of time
+    TWI_ERR_BUS // Bus error or lost arbitration
+} twi_status_t;
+
+// Struct for counting TWI errors
+typedef struct {
+    uint16_t nacks;
+    uint16_t timeouts;
+    uint16_t bus_errors;
+    uint16_t recoveries;
+    uint16_t failures; // Transactions that failed every attempt
+} twi_errors_t;
 
 // Struct for collecting sensor data
 typedef struct {
@@ -154,14 +229,21 @@ typedef struct {
 } MAX30102_sample_t;
 
 void MAX30102_bitMask(uint8_t reg, uint8_t mask, uint8_t value);
-void MAX30102_softReset();
+bool MAX30102_softReset();
 void MAX30102_setup();
 void MAX30102_init();
-void MAX30102_buffer_data(uint8_t toGet, uint8_t *buffer);
+bool MAX30102_buffer_data(uint8_t toGet, uint8_t *buffer);
+bool MAX30102_read_register(uint8_t reg, uint8_t *value);
 uint8_t MAX30102_readRegister8(uint8_t reg);
-void MAX30102_writeRegister8(uint8_t reg, uint8_t value);
-void MAX30102_get_sample(MAX30102_sample_t *sample);
+bool MAX30102_writeRegister8(uint8_t reg, uint8_t value);
+bool MAX30102_get_sample(MAX30102_sample_t *sample);
+void MAX30102_decode_sample(const uint8_t *buffer, MAX30102_sample_t *sample);
 void MAX30102_clearFIFO();
+uint8_t MAX30102_available();
+uint8_t MAX30102_overflow();
+void MAX30102_set_led_amplitudes(uint8_t red, uint8_t ir);
+uint16_t MAX30102_led_current();
+const twi_errors_t *MAX30102_errors();
 void RTC_init(void);
 
 #endif	/* MAX30102_H */
@@ -1,4 +1,6 @@
 #include "max30102_math.h"
+#include "fir_coeffs.h"
+#include <math.h>
 /*
  * The code for the avg_DC_estimator function and low_pass_FIR_filter is adapted
  * from https://github.com/sparkfun/SparkFun_MAX3010x_Sensor_Library/tree/master.
@@ -6,8 +8,31 @@
  * MAX30102 sensor and the frequency of readings the board was doing.
  * I also rewrote some parts for more efficiency and readability.
  * I wrote my own code for calculating spo2 (blood oxygen)
+ *
+ * SpO2 is measured over whole cardiac cycles, from one beat to the next.
+ * Each channel has its own DC estimator and FIR, and every sample only
+ * updates the extremes of the filtered signal and the sum of the raw one.
+ * At the beat the peak to trough of the filtered signal is the AC and the
+ * mean of the raw signal the DC of the cycle. Both channels go through the
+ * same filters, so their gain cancels out of R. The last SPO2_WINDOW beats
+ * are kept and the estimate leaves out the ones far from their median.
  */
 
+// History of one FIR filter, each signal has its own
+typedef struct {
+    int16_t buffer[FIR_BUFFER];
+    uint8_t offset;
+} fir_state_t;
+
+// SpO2 state of one channel over the cardiac cycle in progress
+typedef struct {
+    int32_t dc_reg; // DC estimator feeding the FIR
+    fir_state_t fir;
+    int16_t ac_max; // Extremes of the filtered signal
+    int16_t ac_min;
+    uint32_t sum; // Sum of the raw readings
+} spo2_channel_t;
+
 // Global variables for heart rate detection
 int16_t IR_AC_Max = 30;
 int16_t IR_AC_Min = -30;
@@ -21,36 +46,56 @@ int16_t IR_Average_Estimated;
 int16_t positiveEdge = 0;
 int16_t negativeEdge = 0;
 int32_t ir_avg_reg = 0;
+uint8_t samples_since_crossing = BEAT_REFRACTORY;
+
+fir_state_t beat_fir;
 
-int16_t cbuf[32];
-uint8_t offset = 0;
+// Heart rate of the last beats for the BPM average
+uint8_t rates[RATE_SIZE] = {0};
+uint8_t rate_spot = 0;
 
-float spo2_running_average = 0.0;
-uint32_t spo2_sample_count = 0;
+// Cardiac cycle being measured, only valid once it started at a beat
+spo2_channel_t spo2_ir;
+spo2_channel_t spo2_red;
+uint16_t spo2_cycle_length = 0;
+bool spo2_cycle_valid = false;
 
-// FIRCoeffs taken from https://github.com/sparkfun/SparkFun_MAX3010x_Sensor_Library/tree/master
-static const uint16_t FIRCoeffs[12] = {172, 321, 579, 927, 1360, 1858, 2390, 2916, 3391, 3768, 4012, 4096};
+// SpO2 of the last beats
+float spo2_window[SPO2_WINDOW];
+uint8_t spo2_window_count = 0;
+uint8_t spo2_window_index = 0;
+
+// Calibration, SpO2 = a - b * R and the AC amplitude window for a beat
+float spo2_coeff_a = 110.0;
+float spo2_coeff_b = 25.0;
+int16_t beat_amplitude_min = 40;
+int16_t beat_amplitude_max = 1300;
 
 /**
  * Low Pass FIR Filter
+ * @param fir history of the signal being filtered
  * @param din input value
  * @return resulting value
  */
-int16_t low_pass_FIR_filter(int16_t din) {
+static int16_t low_pass_FIR_filter(fir_state_t *fir, int16_t din) {
+    int16_t *cbuf = fir->buffer;
+    uint8_t offset = fir->offset;
+
     // Update the circular buffer with the new input sample
     cbuf[offset] = din;
 
     // Compute the center tap multiplication
-    int32_t z = FIRCoeffs[11] * (cbuf[(offset - 11) & 0x1F]);
+    int32_t z = (int32_t)FIRCoeffs[FIR_TAPS / 2] * cbuf[(offset - FIR_TAPS / 2) & (FIR_BUFFER - 1)];
 
-    // Compute the weighted sum of symmetric taps
-    for (uint8_t i = 0; i < 11; i++) {
-        z += FIRCoeffs[i] * (cbuf[(offset - i) & 0x1F] + cbuf[(offset - 22 + i) & 0x1F]);
+    // Compute the weighted sum of symmetric taps, the sum of the pair and the
+    // product need 32 bits
+    for (uint8_t i = 0; i < FIR_TAPS / 2; i++) {
+        int32_t pair = (int32_t)cbuf[(offset - i) & (FIR_BUFFER - 1)] + cbuf[(offset - (FIR_TAPS - 1) + i) & (FIR_BUFFER - 1)];
+        z += FIRCoeffs[i] * pair;
     }
 
     // Increment and wrap the offset for the circular buffer
-    offset++;
-    offset %= 32;
+    fir->offset = (offset + 1) % FIR_BUFFER;
 
     // Scale back to 16 bits and return the result
     return (z >> 15);
@@ -85,10 +130,16 @@ bool check_for_beat(int32_t ir_val) {
 
     // Process next data sample
     IR_Average_Estimated = avg_DC_estimator(&ir_avg_reg, ir_val);
-    IR_AC_Signal_Current = low_pass_FIR_filter(ir_val - IR_Average_Estimated);
+    IR_AC_Signal_Current = low_pass_FIR_filter(&beat_fir, ir_val - IR_Average_Estimated);
 
-    // Detect positive zero crossing (rising edge)
-    if ((IR_AC_Signal_Previous < 0) && (IR_AC_Signal_Current >= 0)) {
+    if (samples_since_crossing < BEAT_REFRACTORY) {
+        samples_since_crossing++;
+    }
+
+    // Detect positive zero crossing (rising edge), outside the refractory
+    // period of the last one
+    if ((IR_AC_Signal_Previous < 0) && (IR_AC_Signal_Current >= 0) && samples_since_crossing >= BEAT_REFRACTORY) {
+        samples_since_crossing = 0;
         // Adjust AC max and min
         IR_AC_Max = IR_AC_Signal_max;
         IR_AC_Min = IR_AC_Signal_min;
@@ -97,7 +148,7 @@ bool check_for_beat(int32_t ir_val) {
         negativeEdge = 0;
         IR_AC_Signal_max = 0;
 
-        if ((IR_AC_Max - IR_AC_Min) > 40 && (IR_AC_Max - IR_AC_Min) < 1300) {
+        if ((IR_AC_Max - IR_AC_Min) > beat_amplitude_min && (IR_AC_Max - IR_AC_Min) < beat_amplitude_max) {
             beatDetected = true;
         }
     }
@@ -123,45 +174,203 @@ bool check_for_beat(int32_t ir_val) {
 }
 
 /**
- * Handles calculating the blood oxygen
- * @param ir_val ir value from sample
- * @param red_val red value from sample
+ * Get the filtered IR AC signal from the last call to check_for_beat
+ * @return IR AC signal
  */
-void calculate_and_update_spo2(int32_t ir_val, int32_t red_val, float *spo2_average_out) {
-    static int32_t ir_avg_reg = 0, red_avg_reg = 0;
+int16_t get_IR_AC_signal() {
+    return IR_AC_Signal_Current;
+}
 
-    // Estimate DC and AC components
-    int16_t DC_IR = avg_DC_estimator(&ir_avg_reg, ir_val);
-    int16_t AC_IR = low_pass_FIR_filter(ir_val - DC_IR);
+/**
+ * Add a beat to the heart rate average, beats outside BPM_MIN to BPM_MAX are
+ * left out
+ * @param interval_ms time since the beat before
+ * @param average_bpm_out updated with the average of the last RATE_SIZE beats
+ * @return true if the beat went into the average
+ */
+bool average_beat(uint32_t interval_ms, float *average_bpm_out) {
+    float beats_per_minute = 60 / (interval_ms / 1000.0);
+    if (beats_per_minute >= BPM_MAX || beats_per_minute <= BPM_MIN) {
+        return false;
+    }
 
-    int16_t DC_Red = avg_DC_estimator(&red_avg_reg, red_val);
-    int16_t AC_Red = low_pass_FIR_filter(red_val - DC_Red);
+    rates[rate_spot++] = (uint8_t)beats_per_minute;
+    rate_spot %= RATE_SIZE;
 
-    // Avoid division by zero
-    if (DC_Red == 0 || DC_IR == 0 || AC_IR == 0) {
-        return;
+    *average_bpm_out = 0;
+    for (uint8_t i = 0; i < RATE_SIZE; i++) {
+        *average_bpm_out += rates[i];
     }
+    *average_bpm_out /= RATE_SIZE;
+    return true;
+}
 
-    // Calculate the R value
-    float R = ((float)AC_Red / DC_Red) / ((float)AC_IR / DC_IR);
+/**
+ * Clear the FIR history of a signal
+ * @param fir filter to clear
+ */
+static void reset_fir(fir_state_t *fir) {
+    for (uint8_t i = 0; i < FIR_BUFFER; i++) {
+        fir->buffer[i] = 0;
+    }
+    fir->offset = 0;
+}
+
+/**
+ * Start measuring a new cardiac cycle on a channel
+ * @param channel channel to restart
+ */
+static void spo2_start_cycle(spo2_channel_t *channel) {
+    channel->ac_max = INT16_MIN;
+    channel->ac_min = INT16_MAX;
+    channel->sum = 0;
+}
 
-    // Compute blood oxygen with calibrated coefficients
-    float spo2 = 110.0 - 25.0 * R;
+/**
+ * Add a reading to the cycle of a channel
+ * @param channel channel the reading is from
+ * @param value raw reading
+ */
+static void spo2_channel_update(spo2_channel_t *channel, int32_t value) {
+    int16_t dc = avg_DC_estimator(&channel->dc_reg, value);
+    int16_t ac = low_pass_FIR_filter(&channel->fir, value - dc);
 
-    // Clamp values to realistic range
-    if (spo2 > 100.0) {
-        spo2 = 100.0;
+    if (ac > channel->ac_max) {
+        channel->ac_max = ac;
     }
-    if (spo2 < 70.0) {
-        spo2 = 70.0;
+    if (ac < channel->ac_min) {
+        channel->ac_min = ac;
     }
+    channel->sum += value;
+}
 
-    // Update running average
-    spo2_sample_count++;
-    spo2_running_average += (spo2 - spo2_running_average) / spo2_sample_count;
+/**
+ * Compute the AC over DC of a channel for the finished cycle
+ * @param channel channel to use
+ * @return perfusion of the cycle, 0 if there is no pulse
+ */
+static float spo2_perfusion(const spo2_channel_t *channel) {
+    float ac = (int32_t)channel->ac_max - channel->ac_min;
+    float dc = (float)channel->sum / spo2_cycle_length;
 
-    // Update the output parameter
-    *spo2_average_out = spo2_running_average;
+    if (ac <= 0 || dc <= 0) {
+        return 0;
+    }
+    return ac / dc;
+}
+
+/**
+ * Estimate SpO2 from the window, leaving out the beats far from the median
+ * @return SpO2 estimate
+ */
+static float spo2_estimate() {
+    float sorted[SPO2_WINDOW];
+    uint8_t n = spo2_window_count;
+
+    // Insertion sort, the window is only a few beats long
+    for (uint8_t i = 0; i < n; i++) {
+        float value = spo2_window[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    float median = (n & 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+    float sum = 0;
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        if (fabsf(sorted[i] - median) <= SPO2_OUTLIER) {
+            sum += sorted[i];
+            count++;
+        }
+    }
+    return count > 0 ? sum / count : median;
+}
+
+/**
+ * Handles calculating the blood oxygen, call for every sample
+ * @param ir_val ir value from sample
+ * @param red_val red value from sample
+ * @param beat true if check_for_beat found a beat at this sample
+ * @param keep true if the beat is good enough to update SpO2
+ * @param spo2_average_out updated with the estimate when a beat is kept
+ */
+void calculate_and_update_spo2(int32_t ir_val, int32_t red_val, bool beat, bool keep, float *spo2_average_out) {
+    spo2_channel_update(&spo2_ir, ir_val);
+    spo2_channel_update(&spo2_red, red_val);
+
+    // A cycle without a beat for too long is not measured
+    if (spo2_cycle_length < SPO2_MAX_CYCLE) {
+        spo2_cycle_length++;
+    } else {
+        spo2_cycle_valid = false;
+    }
+
+    if (!beat) {
+        return;
+    }
+
+    if (spo2_cycle_valid && keep) {
+        float perfusion_ir = spo2_perfusion(&spo2_ir);
+        float perfusion_red = spo2_perfusion(&spo2_red);
+
+        if (perfusion_ir > 0 && perfusion_red > 0) {
+            // Calculate the R value
+            float R = perfusion_red / perfusion_ir;
+
+            if (R >= SPO2_R_MIN && R <= SPO2_R_MAX) {
+                // Compute blood oxygen with calibrated coefficients
+                float spo2 = spo2_coeff_a - spo2_coeff_b * R;
+
+                // Clamp values to realistic range
+                if (spo2 > 100.0) {
+                    spo2 = 100.0;
+                }
+                if (spo2 < 70.0) {
+                    spo2 = 70.0;
+                }
+
+                spo2_window[spo2_window_index] = spo2;
+                spo2_window_index = (spo2_window_index + 1) % SPO2_WINDOW;
+                if (spo2_window_count < SPO2_WINDOW) {
+                    spo2_window_count++;
+                }
+
+                // Update the output parameter
+                *spo2_average_out = spo2_estimate();
+            }
+        }
+    }
+
+    // The beat starts the next cycle
+    spo2_start_cycle(&spo2_ir);
+    spo2_start_cycle(&spo2_red);
+    spo2_cycle_length = 0;
+    spo2_cycle_valid = true;
+}
+
+/**
+ * Set the calibration curve used to turn R into SpO2
+ * @param a offset of the curve
+ * @param b slope of the curve
+ */
+void set_spo2_coefficients(float a, float b) {
+    spo2_coeff_a = a;
+    spo2_coeff_b = b;
+}
+
+/**
+ * Set the IR AC amplitude window a beat has to fall in
+ * @param min_amplitude smallest peak to peak amplitude of a beat
+ * @param max_amplitude largest peak to peak amplitude of a beat
+ */
+void set_beat_thresholds(int16_t min_amplitude, int16_t max_amplitude) {
+    beat_amplitude_min = min_amplitude;
+    beat_amplitude_max = max_amplitude;
 }
 
 /**
@@ -181,10 +390,26 @@ void reset_math_globals() {
     positiveEdge = 0;
     negativeEdge = 0;
     ir_avg_reg = 0;
+    samples_since_crossing = BEAT_REFRACTORY;
 
     // Reset circular buffer and offset
-    for (int i = 0; i < 32; i++) {
-        cbuf[i] = 0;
+    reset_fir(&beat_fir);
+
+    // Reset the BPM average
+    for (uint8_t i = 0; i < RATE_SIZE; i++) {
+        rates[i] = 0;
     }
-    offset = 0;
+    rate_spot = 0;
+
+    // Reset the SpO2 channels and window
+    spo2_ir.dc_reg = 0;
+    spo2_red.dc_reg = 0;
+    reset_fir(&spo2_ir.fir);
+    reset_fir(&spo2_red.fir);
+    spo2_start_cycle(&spo2_ir);
+    spo2_start_cycle(&spo2_red);
+    spo2_cycle_length = 0;
+    spo2_cycle_valid = false;
+    spo2_window_count = 0;
+    spo2_window_index = 0;
 }
\ No newline at end of file
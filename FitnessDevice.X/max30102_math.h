@@ -4,11 +4,46 @@
 #ifndef MAX30102_MATH_H
 #define	MAX30102_MATH_H
 
-int16_t low_pass_FIR_filter(int16_t din);
+// Rate the sensor samples at, without averaging on the chip
+#define PPG_SENSOR_RATE 400
+
+// The acquisition brings the sensor rate down to the rate the HR and SpO2
+// processing runs at, and the time between those samples in ms. The FIR
+// table in fir_coeffs.h is picked for PPG_SAMPLE_RATE.
+#define PPG_DECIMATION 4
+#define PPG_SAMPLE_RATE (PPG_SENSOR_RATE / PPG_DECIMATION)
+#define PPG_SAMPLE_PERIOD (1000 / PPG_SAMPLE_RATE)
+
+// Rising zero crossings closer than this to the last one are taken as the
+// dicrotic wave or noise, not a beat (250 ms, 240 bpm)
+#define BEAT_REFRACTORY (PPG_SAMPLE_RATE / 4)
+
+// Beats in the heart rate average and the heart rates a beat may give, the
+// interval of anything outside is taken as a missed or extra beat
+#define RATE_SIZE 4
+#define BPM_MIN 20
+#define BPM_MAX 255
+
+// Beats in the SpO2 window. The estimate is the mean of the beats within
+// SPO2_OUTLIER (% SpO2) of the window's median.
+#define SPO2_WINDOW 8
+#define SPO2_OUTLIER 3.0f
+
+// Ratio of ratios a real beat falls in
+#define SPO2_R_MIN 0.3f
+#define SPO2_R_MAX 2.5f
+
+// Longest cardiac cycle that is measured, 2.5 s (24 bpm)
+#define SPO2_MAX_CYCLE (PPG_SAMPLE_RATE * 5 / 2)
+
 int16_t avg_DC_estimator(int32_t *dc_component, uint32_t input_value);
 bool check_for_beat(int32_t ir_val);
+int16_t get_IR_AC_signal();
+bool average_beat(uint32_t interval_ms, float *average_bpm_out);
 void reset_math_globals();
-void calculate_and_update_spo2(int32_t ir_val, int32_t red_val, float *spo2_average_out);
+void set_spo2_coefficients(float a, float b);
+void set_beat_thresholds(int16_t min_amplitude, int16_t max_amplitude);
+void calculate_and_update_spo2(int32_t ir_val, int32_t red_val, bool beat, bool keep, float *spo2_average_out);
 
 #endif	/* MAX30102_MATH_H */
 
@@ -0,0 +1,118 @@
+#include "motion_filter.h"
+/*
+ * Adaptive noise canceller for motion artifacts in the PPG signal.
+ * The EMG reading taken at the same time as each PPG sample is used as a
+ * motion reference. A normalized LMS filter learns how much of the reference
+ * leaks into each PPG channel and subtracts it, leaving the pulse waveform.
+ * Everything is fixed point so it runs at the PPG sample rate.
+ */
+
+// Reference history (DC removed EMG readings)
+int16_t motion_ref[MOTION_TAPS] = {0};
+uint8_t motion_ref_offset = 0;
+int32_t motion_ref_power = 0;
+int32_t motion_ref_dc = 0;
+
+// Per channel filter weights (Q12) and DC estimate (Q8)
+int32_t motion_weights[MOTION_CHANNELS][MOTION_TAPS] = {{0}};
+int32_t motion_ppg_dc[MOTION_CHANNELS] = {0};
+
+/**
+ * Adds a new EMG reading to the reference history
+ * @param emg_val ADC reading taken together with the PPG sample
+ */
+void motion_reference_update(uint16_t emg_val) {
+    // Remove the DC level of the muscle sensor (Q8 smoothing, alpha = 1/128)
+    if (motion_ref_dc == 0) {
+        motion_ref_dc = (int32_t)emg_val << 8;
+    }
+    motion_ref_dc += (((int32_t)emg_val << 8) - motion_ref_dc) >> 7;
+    // Back to ~4x ADC resolution, small enough that the power sum fits 32 bits
+    int16_t x = (int16_t)((((int32_t)emg_val << 8) - motion_ref_dc) >> 6);
+
+    // Keep the power of the window up to date without summing every tap
+    motion_ref_offset = (motion_ref_offset + 1) % MOTION_TAPS;
+    int16_t oldest = motion_ref[motion_ref_offset];
+    motion_ref_power -= (int32_t)oldest * oldest;
+    motion_ref_power += (int32_t)x * x;
+    motion_ref[motion_ref_offset] = x;
+}
+
+/**
+ * Removes the part of a PPG sample that is correlated with the EMG reference
+ * @param channel MOTION_IR or MOTION_RED
+ * @param ppg_val raw value from the MAX30102
+ * @return cleaned PPG value
+ */
+uint32_t motion_cancel(uint8_t channel, uint32_t ppg_val) {
+    int32_t *w = motion_weights[channel];
+    int32_t *dc = &motion_ppg_dc[channel];
+
+    // Track the DC level of the channel (Q8) so only the AC part is adapted on.
+    // This is much slower than the beat detector's DC estimator so the pulse
+    // itself passes through untouched
+    if (*dc == 0) {
+        *dc = (int32_t)ppg_val << 8;
+    }
+    *dc += (((int32_t)ppg_val << 8) - *dc) >> 7;
+    int32_t dc_val = *dc >> 8;
+    int32_t d = (int32_t)ppg_val - dc_val;
+
+    // Clamp to 16 bits so the update below cannot overflow
+    if (d > INT16_MAX) {
+        d = INT16_MAX;
+    } else if (d < INT16_MIN) {
+        d = INT16_MIN;
+    }
+
+    // Filter output is the estimated artifact
+    int32_t y = 0;
+    uint8_t idx = motion_ref_offset;
+    for (uint8_t i = 0; i < MOTION_TAPS; i++) {
+        y += w[i] * motion_ref[idx];
+        idx = idx == 0 ? MOTION_TAPS - 1 : idx - 1;
+    }
+    y >>= MOTION_WEIGHT_SHIFT;
+
+    int32_t e = d - y;
+    if (e > INT16_MAX) {
+        e = INT16_MAX;
+    } else if (e < INT16_MIN) {
+        e = INT16_MIN;
+    }
+
+    // NLMS update, one division per sample: g = e / (power + epsilon)
+    int32_t g = (e << MOTION_WEIGHT_SHIFT) / (motion_ref_power + MOTION_EPSILON);
+    idx = motion_ref_offset;
+    for (uint8_t i = 0; i < MOTION_TAPS; i++) {
+        w[i] += (g * motion_ref[idx]) >> MOTION_MU_SHIFT;
+        if (w[i] > MOTION_WEIGHT_LIMIT) {
+            w[i] = MOTION_WEIGHT_LIMIT;
+        } else if (w[i] < -MOTION_WEIGHT_LIMIT) {
+            w[i] = -MOTION_WEIGHT_LIMIT;
+        }
+        idx = idx == 0 ? MOTION_TAPS - 1 : idx - 1;
+    }
+
+    // Put the DC level back so the rest of the pipeline sees a normal sample
+    int32_t cleaned = dc_val + e;
+    return cleaned > 0 ? (uint32_t)cleaned : 0;
+}
+
+/**
+ * Reset the adaptive filter between readings
+ */
+void reset_motion_globals() {
+    for (uint8_t i = 0; i < MOTION_TAPS; i++) {
+        motion_ref[i] = 0;
+        for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+            motion_weights[c][i] = 0;
+        }
+    }
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        motion_ppg_dc[c] = 0;
+    }
+    motion_ref_offset = 0;
+    motion_ref_power = 0;
+    motion_ref_dc = 0;
+}
@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef MOTION_FILTER_H
+#define	MOTION_FILTER_H
+
+// Number of taps in the adaptive filter (EMG history used as reference)
+#define MOTION_TAPS 8
+
+// Step size of the NLMS update as a right shift (mu = 1 / 2^MOTION_MU_SHIFT)
+#define MOTION_MU_SHIFT 5
+
+// Regularization added to the reference power so quiet EMG does not blow up
+// the step size (about 8 taps of +/-180 counts)
+#define MOTION_EPSILON 262144L
+
+// Fixed point format of the filter weights (Q12)
+#define MOTION_WEIGHT_SHIFT 12
+#define MOTION_WEIGHT_LIMIT (8L << MOTION_WEIGHT_SHIFT)
+
+// PPG channels that get cleaned
+#define MOTION_IR 0
+#define MOTION_RED 1
+#define MOTION_CHANNELS 2
+
+void motion_reference_update(uint16_t emg_val);
+uint32_t motion_cancel(uint8_t channel, uint32_t ppg_val);
+void reset_motion_globals();
+
+#endif	/* MOTION_FILTER_H */
+
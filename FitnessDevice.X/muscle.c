@@ -1,44 +1,64 @@
 #include "muscle.h"
 
+// Inputs of the muscle sensors
+static const uint8_t emg_channel_ain[EMG_CHANNELS] = EMG_CHANNEL_AIN;
+
 /**
- * Initialize ADC communication on pin D1
+ * Initialize ADC communication on the muscle sensor pins of port D
  */
 void ADC_init() {
-    // DISABLE DIGITAL INPUT BUFFER
-    PORTD.PIN1CTRL &= ~PORT_ISC_gm;
-    PORTD.PIN1CTRL |= PORT_ISC_INPUT_DISABLE_gc;
-    
-    // DISABLE PULLUP RESISTOR
-    PORTD.PIN1CTRL &= ~PORT_PULLUPEN_bm;
+    for (uint8_t i = 0; i < EMG_CHANNELS; i++) {
+        volatile uint8_t *pin_ctrl = &PORTD.PIN0CTRL + emg_channel_ain[i];
+
+        // DISABLE DIGITAL INPUT BUFFER
+        *pin_ctrl &= ~PORT_ISC_gm;
+        *pin_ctrl |= PORT_ISC_INPUT_DISABLE_gc;
+
+        // DISABLE PULLUP RESISTOR
+        *pin_ctrl &= ~PORT_PULLUPEN_bm;
+    }
     
-    // SELECT ADC CHANNEL AIN1 = PD1
-    ADC0.MUXPOS  = ADC_MUXPOS_AIN1_gc;
+    // SELECT THE FIRST MUSCLE SENSOR
+    ADC_select(0);
     
-    // SET INTERNAL REFERENCE AND DIVIDE BY 4
-    ADC0.CTRLC = ADC_PRESC_DIV4_gc
+    // SET INTERNAL REFERENCE AND DIVIDE BY 8 (1.25 MHz, the most allowed
+    // is 1.5 MHz)
+    ADC0.CTRLC = ADC_PRESC_DIV8_gc
                | ADC_REFSEL_VDDREF_gc;
    
-    // ENABLE ADC IN FREERUN AND 10-BIT MODE
+    // ENABLE ADC IN 10-BIT MODE, EACH CONVERSION IS STARTED BY ADC_start()
     ADC0.CTRLA = ADC_RESSEL_10BIT_gc
                | ADC_ENABLE_bm;
 }
 
 /**
- * Read from the ADC (value is from 0 to 1023)
- * @return ADC reading
+ * Point the ADC at a muscle sensor, takes effect on the next conversion
+ * @param channel index into EMG_CHANNEL_AIN
+ */
+void ADC_select(uint8_t channel) {
+    ADC0.MUXPOS = emg_channel_ain[channel];
+}
+
+/**
+ * Start a conversion without waiting for it to finish
  */
-uint16_t ADC_read() {
-    // Start conversion
+void ADC_start() {
     ADC0.COMMAND = ADC_STCONV_bm;
+}
 
-    // Wait for conversion to complete
-    while (!(ADC0.INTFLAGS & ADC_RESRDY_bm)) {
-        // Wait for result ready flag
-    }
+/**
+ * Check if the conversion started by ADC_start() has finished
+ * @return true if a result is ready
+ */
+bool ADC_ready() {
+    return ADC0.INTFLAGS & ADC_RESRDY_bm;
+}
 
-    // Clear result ready flag
+/**
+ * Get the result of the last conversion and clear the ready flag
+ * @return ADC reading
+ */
+uint16_t ADC_result() {
     ADC0.INTFLAGS = ADC_RESRDY_bm;
-
-    // Return ADC result
     return ADC0.RES;
-}
\ No newline at end of file
+}
@@ -1,8 +1,9 @@
 #ifndef F_CPU
-#define F_CPU 3333333
+#define F_CPU 10000000
 #endif
 
 #include <avr/io.h>
+#include <stdbool.h>
 #include <util/delay.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,8 +13,18 @@
 #ifndef MUSCLE_H
 #define	MUSCLE_H
 
+// Muscle sensors scanned by the acquisition, as AIN numbers (AINn is PDn and
+// its MUXPOS value is n). The first one is the sensor the baseline and
+// intensity are measured on. The board has one MyoWare sensor on PD1, a
+// board with more lists their inputs here, e.g. 4 and {1, 0, 4, 6}.
+#define EMG_CHANNELS 1
+#define EMG_CHANNEL_AIN {1}
+
 void ADC_init();
-uint16_t ADC_read();
+void ADC_select(uint8_t channel);
+void ADC_start();
+bool ADC_ready();
+uint16_t ADC_result();
 
 #endif	/* MUSCLE_H */
 
@@ -51,17 +51,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=muscle.c max30102.c bluetooth.c button_led.c max30102_math.c newavr-main.c
+SOURCEFILES_QUOTED_IF_SPACED=muscle.c max30102.c bluetooth.c button_led.c max30102_math.c newavr-main.c motion_filter.c signal_quality.c acquisition.c calibration.c feedback.c diagnostics.c scratch.c decimator.c capture.c session.c telemetry.c stats.c fatigue.c energy.c baseline.c heart_rate.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/muscle.o ${OBJECTDIR}/max30102.o ${OBJECTDIR}/bluetooth.o ${OBJECTDIR}/button_led.o ${OBJECTDIR}/max30102_math.o ${OBJECTDIR}/newavr-main.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/muscle.o.d ${OBJECTDIR}/max30102.o.d ${OBJECTDIR}/bluetooth.o.d ${OBJECTDIR}/button_led.o.d ${OBJECTDIR}/max30102_math.o.d ${OBJECTDIR}/newavr-main.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/muscle.o ${OBJECTDIR}/max30102.o ${OBJECTDIR}/bluetooth.o ${OBJECTDIR}/button_led.o ${OBJECTDIR}/max30102_math.o ${OBJECTDIR}/newavr-main.o ${OBJECTDIR}/motion_filter.o ${OBJECTDIR}/signal_quality.o ${OBJECTDIR}/acquisition.o ${OBJECTDIR}/calibration.o ${OBJECTDIR}/feedback.o ${OBJECTDIR}/diagnostics.o ${OBJECTDIR}/scratch.o ${OBJECTDIR}/decimator.o ${OBJECTDIR}/capture.o ${OBJECTDIR}/session.o ${OBJECTDIR}/telemetry.o ${OBJECTDIR}/stats.o ${OBJECTDIR}/fatigue.o ${OBJECTDIR}/energy.o ${OBJECTDIR}/baseline.o ${OBJECTDIR}/heart_rate.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/muscle.o.d ${OBJECTDIR}/max30102.o.d ${OBJECTDIR}/bluetooth.o.d ${OBJECTDIR}/button_led.o.d ${OBJECTDIR}/max30102_math.o.d ${OBJECTDIR}/newavr-main.o.d ${OBJECTDIR}/motion_filter.o.d ${OBJECTDIR}/signal_quality.o.d ${OBJECTDIR}/acquisition.o.d ${OBJECTDIR}/calibration.o.d ${OBJECTDIR}/feedback.o.d ${OBJECTDIR}/diagnostics.o.d ${OBJECTDIR}/scratch.o.d ${OBJECTDIR}/decimator.o.d ${OBJECTDIR}/capture.o.d ${OBJECTDIR}/session.o.d ${OBJECTDIR}/telemetry.o.d ${OBJECTDIR}/stats.o.d ${OBJECTDIR}/fatigue.o.d ${OBJECTDIR}/energy.o.d ${OBJECTDIR}/baseline.o.d ${OBJECTDIR}/heart_rate.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/muscle.o ${OBJECTDIR}/max30102.o ${OBJECTDIR}/bluetooth.o ${OBJECTDIR}/button_led.o ${OBJECTDIR}/max30102_math.o ${OBJECTDIR}/newavr-main.o
+OBJECTFILES=${OBJECTDIR}/muscle.o ${OBJECTDIR}/max30102.o ${OBJECTDIR}/bluetooth.o ${OBJECTDIR}/button_led.o ${OBJECTDIR}/max30102_math.o ${OBJECTDIR}/newavr-main.o ${OBJECTDIR}/motion_filter.o ${OBJECTDIR}/signal_quality.o ${OBJECTDIR}/acquisition.o ${OBJECTDIR}/calibration.o ${OBJECTDIR}/feedback.o ${OBJECTDIR}/diagnostics.o ${OBJECTDIR}/scratch.o ${OBJECTDIR}/decimator.o ${OBJECTDIR}/capture.o ${OBJECTDIR}/session.o ${OBJECTDIR}/telemetry.o ${OBJECTDIR}/stats.o ${OBJECTDIR}/fatigue.o ${OBJECTDIR}/energy.o ${OBJECTDIR}/baseline.o ${OBJECTDIR}/heart_rate.o
 
 # Source Files
-SOURCEFILES=muscle.c max30102.c bluetooth.c button_led.c max30102_math.c newavr-main.c
+SOURCEFILES=muscle.c max30102.c bluetooth.c button_led.c max30102_math.c newavr-main.c motion_filter.c signal_quality.c acquisition.c calibration.c feedback.c diagnostics.c scratch.c decimator.c capture.c session.c telemetry.c stats.c fatigue.c energy.c baseline.c heart_rate.c
 
 
 
@@ -124,6 +124,102 @@ ${OBJECTDIR}/newavr-main.o: newavr-main.c  .generated_files/flags/default/20eae2
 	@${RM} ${OBJECTDIR}/newavr-main.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/newavr-main.o.d" -MT "${OBJECTDIR}/newavr-main.o.d" -MT ${OBJECTDIR}/newavr-main.o -o ${OBJECTDIR}/newavr-main.o newavr-main.c 
 	
+${OBJECTDIR}/heart_rate.o: heart_rate.c  .generated_files/flags/default/f92dd2ff7ddb96a8c89052340a19866d7befe273 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/heart_rate.o.d 
+	@${RM} ${OBJECTDIR}/heart_rate.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/heart_rate.o.d" -MT "${OBJECTDIR}/heart_rate.o.d" -MT ${OBJECTDIR}/heart_rate.o -o ${OBJECTDIR}/heart_rate.o heart_rate.c 
+	
+${OBJECTDIR}/baseline.o: baseline.c  .generated_files/flags/default/c55eb924f834beb3d3fc765b6469ed2aa210f4f7 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/baseline.o.d 
+	@${RM} ${OBJECTDIR}/baseline.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/baseline.o.d" -MT "${OBJECTDIR}/baseline.o.d" -MT ${OBJECTDIR}/baseline.o -o ${OBJECTDIR}/baseline.o baseline.c 
+	
+${OBJECTDIR}/energy.o: energy.c  .generated_files/flags/default/063d81013a01a680a05e5ba2d42c898a5f2b5d9a .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/energy.o.d 
+	@${RM} ${OBJECTDIR}/energy.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/energy.o.d" -MT "${OBJECTDIR}/energy.o.d" -MT ${OBJECTDIR}/energy.o -o ${OBJECTDIR}/energy.o energy.c 
+	
+${OBJECTDIR}/fatigue.o: fatigue.c  .generated_files/flags/default/4190b2eb883dd2743a63374ff89e2c85b834b564 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/fatigue.o.d 
+	@${RM} ${OBJECTDIR}/fatigue.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/fatigue.o.d" -MT "${OBJECTDIR}/fatigue.o.d" -MT ${OBJECTDIR}/fatigue.o -o ${OBJECTDIR}/fatigue.o fatigue.c 
+	
+${OBJECTDIR}/stats.o: stats.c  .generated_files/flags/default/38d46dc1bc075fdf36425d6b87b3b553433b7355 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stats.o.d 
+	@${RM} ${OBJECTDIR}/stats.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/stats.o.d" -MT "${OBJECTDIR}/stats.o.d" -MT ${OBJECTDIR}/stats.o -o ${OBJECTDIR}/stats.o stats.c 
+	
+${OBJECTDIR}/telemetry.o: telemetry.c  .generated_files/flags/default/7c3d3953e293efb845e2266fd03ecf9af1141bb1 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/telemetry.o.d 
+	@${RM} ${OBJECTDIR}/telemetry.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/telemetry.o.d" -MT "${OBJECTDIR}/telemetry.o.d" -MT ${OBJECTDIR}/telemetry.o -o ${OBJECTDIR}/telemetry.o telemetry.c 
+	
+${OBJECTDIR}/session.o: session.c  .generated_files/flags/default/53ca47d18042dd02fce51e63e2fd959094b6d0be .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/session.o.d 
+	@${RM} ${OBJECTDIR}/session.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/session.o.d" -MT "${OBJECTDIR}/session.o.d" -MT ${OBJECTDIR}/session.o -o ${OBJECTDIR}/session.o session.c 
+	
+${OBJECTDIR}/capture.o: capture.c  .generated_files/flags/default/8c93bb365b26205b248f885821fede65ced5726f .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/capture.o.d 
+	@${RM} ${OBJECTDIR}/capture.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/capture.o.d" -MT "${OBJECTDIR}/capture.o.d" -MT ${OBJECTDIR}/capture.o -o ${OBJECTDIR}/capture.o capture.c 
+	
+${OBJECTDIR}/decimator.o: decimator.c  .generated_files/flags/default/b789ee406ab118fc29b8d61e158dbd1f97fb15ff .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/decimator.o.d 
+	@${RM} ${OBJECTDIR}/decimator.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/decimator.o.d" -MT "${OBJECTDIR}/decimator.o.d" -MT ${OBJECTDIR}/decimator.o -o ${OBJECTDIR}/decimator.o decimator.c 
+	
+${OBJECTDIR}/scratch.o: scratch.c  .generated_files/flags/default/3ea218797221cd4cab7cfea9ff04829cffb95c5c .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/scratch.o.d 
+	@${RM} ${OBJECTDIR}/scratch.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/scratch.o.d" -MT "${OBJECTDIR}/scratch.o.d" -MT ${OBJECTDIR}/scratch.o -o ${OBJECTDIR}/scratch.o scratch.c 
+	
+${OBJECTDIR}/diagnostics.o: diagnostics.c  .generated_files/flags/default/9f9a8e4b26d036c5e1779cfd949e2b76e7b1f23a .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/diagnostics.o.d 
+	@${RM} ${OBJECTDIR}/diagnostics.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/diagnostics.o.d" -MT "${OBJECTDIR}/diagnostics.o.d" -MT ${OBJECTDIR}/diagnostics.o -o ${OBJECTDIR}/diagnostics.o diagnostics.c 
+	
+${OBJECTDIR}/feedback.o: feedback.c  .generated_files/flags/default/a922b1e78f1a3bc35fc47576a8439ee1e208092d .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/feedback.o.d 
+	@${RM} ${OBJECTDIR}/feedback.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/feedback.o.d" -MT "${OBJECTDIR}/feedback.o.d" -MT ${OBJECTDIR}/feedback.o -o ${OBJECTDIR}/feedback.o feedback.c 
+	
+${OBJECTDIR}/calibration.o: calibration.c  .generated_files/flags/default/5599b357882e6569d970f68f4a1a01d200cbe494 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/calibration.o.d 
+	@${RM} ${OBJECTDIR}/calibration.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/calibration.o.d" -MT "${OBJECTDIR}/calibration.o.d" -MT ${OBJECTDIR}/calibration.o -o ${OBJECTDIR}/calibration.o calibration.c 
+	
+${OBJECTDIR}/acquisition.o: acquisition.c  .generated_files/flags/default/c6528626bc547d095219e3c4b67ec086b4bcfe69 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/acquisition.o.d 
+	@${RM} ${OBJECTDIR}/acquisition.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/acquisition.o.d" -MT "${OBJECTDIR}/acquisition.o.d" -MT ${OBJECTDIR}/acquisition.o -o ${OBJECTDIR}/acquisition.o acquisition.c 
+	
+${OBJECTDIR}/signal_quality.o: signal_quality.c  .generated_files/flags/default/7a19d41da1e0e5b1ce9e1bfbe9e0ec185fd73b78 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/signal_quality.o.d 
+	@${RM} ${OBJECTDIR}/signal_quality.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/signal_quality.o.d" -MT "${OBJECTDIR}/signal_quality.o.d" -MT ${OBJECTDIR}/signal_quality.o -o ${OBJECTDIR}/signal_quality.o signal_quality.c 
+	
+${OBJECTDIR}/motion_filter.o: motion_filter.c  .generated_files/flags/default/8554d1747eb1673d6cbfae6ef2cc192dd6a92a81 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/motion_filter.o.d 
+	@${RM} ${OBJECTDIR}/motion_filter.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -D__DEBUG=1 -g -DDEBUG  -gdwarf-2  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/motion_filter.o.d" -MT "${OBJECTDIR}/motion_filter.o.d" -MT ${OBJECTDIR}/motion_filter.o -o ${OBJECTDIR}/motion_filter.o motion_filter.c 
+	
 else
 ${OBJECTDIR}/muscle.o: muscle.c  .generated_files/flags/default/5972d3e2532defb2bbeda00ddd2a686fb0a2cd9d .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
 	@${MKDIR} "${OBJECTDIR}" 
@@ -161,6 +257,102 @@ ${OBJECTDIR}/newavr-main.o: newavr-main.c  .generated_files/flags/default/cd2fe8
 	@${RM} ${OBJECTDIR}/newavr-main.o 
 	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/newavr-main.o.d" -MT "${OBJECTDIR}/newavr-main.o.d" -MT ${OBJECTDIR}/newavr-main.o -o ${OBJECTDIR}/newavr-main.o newavr-main.c 
 	
+${OBJECTDIR}/heart_rate.o: heart_rate.c  .generated_files/flags/default/ba5e40f0cfcd5cf20514262dccfe16a64bd245ae .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/heart_rate.o.d 
+	@${RM} ${OBJECTDIR}/heart_rate.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/heart_rate.o.d" -MT "${OBJECTDIR}/heart_rate.o.d" -MT ${OBJECTDIR}/heart_rate.o -o ${OBJECTDIR}/heart_rate.o heart_rate.c 
+	
+${OBJECTDIR}/baseline.o: baseline.c  .generated_files/flags/default/a23c99967aa41121e478da0c29987a02d78ba12e .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/baseline.o.d 
+	@${RM} ${OBJECTDIR}/baseline.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/baseline.o.d" -MT "${OBJECTDIR}/baseline.o.d" -MT ${OBJECTDIR}/baseline.o -o ${OBJECTDIR}/baseline.o baseline.c 
+	
+${OBJECTDIR}/energy.o: energy.c  .generated_files/flags/default/f7171bd71a790ebe751a419024607928586af2ef .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/energy.o.d 
+	@${RM} ${OBJECTDIR}/energy.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/energy.o.d" -MT "${OBJECTDIR}/energy.o.d" -MT ${OBJECTDIR}/energy.o -o ${OBJECTDIR}/energy.o energy.c 
+	
+${OBJECTDIR}/fatigue.o: fatigue.c  .generated_files/flags/default/651c9b45d7359333a8e383c547e39fe25a2c05ed .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/fatigue.o.d 
+	@${RM} ${OBJECTDIR}/fatigue.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/fatigue.o.d" -MT "${OBJECTDIR}/fatigue.o.d" -MT ${OBJECTDIR}/fatigue.o -o ${OBJECTDIR}/fatigue.o fatigue.c 
+	
+${OBJECTDIR}/stats.o: stats.c  .generated_files/flags/default/58d6b33c1dd67651421bc3c1247f491f43167732 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/stats.o.d 
+	@${RM} ${OBJECTDIR}/stats.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/stats.o.d" -MT "${OBJECTDIR}/stats.o.d" -MT ${OBJECTDIR}/stats.o -o ${OBJECTDIR}/stats.o stats.c 
+	
+${OBJECTDIR}/telemetry.o: telemetry.c  .generated_files/flags/default/22dc4eb579df7aee4d191dc601458f2aa05864c3 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/telemetry.o.d 
+	@${RM} ${OBJECTDIR}/telemetry.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/telemetry.o.d" -MT "${OBJECTDIR}/telemetry.o.d" -MT ${OBJECTDIR}/telemetry.o -o ${OBJECTDIR}/telemetry.o telemetry.c 
+	
+${OBJECTDIR}/session.o: session.c  .generated_files/flags/default/ebf3d8c2935deebbd36c78fadc4686e4136676c4 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/session.o.d 
+	@${RM} ${OBJECTDIR}/session.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/session.o.d" -MT "${OBJECTDIR}/session.o.d" -MT ${OBJECTDIR}/session.o -o ${OBJECTDIR}/session.o session.c 
+	
+${OBJECTDIR}/capture.o: capture.c  .generated_files/flags/default/e999805b0178602f61efa4b5d73c714f7e0d66b6 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/capture.o.d 
+	@${RM} ${OBJECTDIR}/capture.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/capture.o.d" -MT "${OBJECTDIR}/capture.o.d" -MT ${OBJECTDIR}/capture.o -o ${OBJECTDIR}/capture.o capture.c 
+	
+${OBJECTDIR}/decimator.o: decimator.c  .generated_files/flags/default/8a7fcb51ce3c705b3f5ac6fc4383e64a2c69c665 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/decimator.o.d 
+	@${RM} ${OBJECTDIR}/decimator.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/decimator.o.d" -MT "${OBJECTDIR}/decimator.o.d" -MT ${OBJECTDIR}/decimator.o -o ${OBJECTDIR}/decimator.o decimator.c 
+	
+${OBJECTDIR}/scratch.o: scratch.c  .generated_files/flags/default/847cc5c66e79b3d6f1bec38a6a13c1ceb89a30f8 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/scratch.o.d 
+	@${RM} ${OBJECTDIR}/scratch.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/scratch.o.d" -MT "${OBJECTDIR}/scratch.o.d" -MT ${OBJECTDIR}/scratch.o -o ${OBJECTDIR}/scratch.o scratch.c 
+	
+${OBJECTDIR}/diagnostics.o: diagnostics.c  .generated_files/flags/default/700d80d53bcea0f5f741b2d31e7cfa8b2e9e18ad .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/diagnostics.o.d 
+	@${RM} ${OBJECTDIR}/diagnostics.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/diagnostics.o.d" -MT "${OBJECTDIR}/diagnostics.o.d" -MT ${OBJECTDIR}/diagnostics.o -o ${OBJECTDIR}/diagnostics.o diagnostics.c 
+	
+${OBJECTDIR}/feedback.o: feedback.c  .generated_files/flags/default/c46ebe2d59acda1e563cd40de9dec1f1e388bd27 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/feedback.o.d 
+	@${RM} ${OBJECTDIR}/feedback.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/feedback.o.d" -MT "${OBJECTDIR}/feedback.o.d" -MT ${OBJECTDIR}/feedback.o -o ${OBJECTDIR}/feedback.o feedback.c 
+	
+${OBJECTDIR}/calibration.o: calibration.c  .generated_files/flags/default/2afab3fe0d4c2ea92c18ae9b9308db479ea9aef5 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/calibration.o.d 
+	@${RM} ${OBJECTDIR}/calibration.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/calibration.o.d" -MT "${OBJECTDIR}/calibration.o.d" -MT ${OBJECTDIR}/calibration.o -o ${OBJECTDIR}/calibration.o calibration.c 
+	
+${OBJECTDIR}/acquisition.o: acquisition.c  .generated_files/flags/default/6b4675c3920019fc415b6d3a65295116860aa24c .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/acquisition.o.d 
+	@${RM} ${OBJECTDIR}/acquisition.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/acquisition.o.d" -MT "${OBJECTDIR}/acquisition.o.d" -MT ${OBJECTDIR}/acquisition.o -o ${OBJECTDIR}/acquisition.o acquisition.c 
+	
+${OBJECTDIR}/signal_quality.o: signal_quality.c  .generated_files/flags/default/3c7b123a416a720305ec68c9d8529e98630f2c7e .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/signal_quality.o.d 
+	@${RM} ${OBJECTDIR}/signal_quality.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/signal_quality.o.d" -MT "${OBJECTDIR}/signal_quality.o.d" -MT ${OBJECTDIR}/signal_quality.o -o ${OBJECTDIR}/signal_quality.o signal_quality.c 
+	
+${OBJECTDIR}/motion_filter.o: motion_filter.c  .generated_files/flags/default/3383baaed58d43231401620a710e97cbd0e1fc55 .generated_files/flags/default/da39a3ee5e6b4b0d3255bfef95601890afd80709
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/motion_filter.o.d 
+	@${RM} ${OBJECTDIR}/motion_filter.o 
+	${MP_CC} $(MP_EXTRA_CC_PRE) -mcpu=$(MP_PROCESSOR_OPTION) -c  -x c -D__$(MP_PROCESSOR_OPTION)__   -mdfp="${DFP_DIR}/xc8"  -Wl,--gc-sections -DXPRJ_default=$(CND_CONF)  $(COMPARISON_BUILD)  -gdwarf-3 -mconst-data-in-progmem -mno-const-data-in-config-mapped-progmem     -MD -MP -MF "${OBJECTDIR}/motion_filter.o.d" -MT "${OBJECTDIR}/motion_filter.o.d" -MT ${OBJECTDIR}/motion_filter.o -o ${OBJECTDIR}/motion_filter.o motion_filter.c 
+	
 endif
 
 # ------------------------------------------------------------------------------------
@@ -1,73 +1,61 @@
 #ifndef F_CPU
-#define F_CPU 3333333
+#define F_CPU 10000000
 #endif
 
 #include "newavr-main.h"
 
+// The state below is only touched by the main loop, the ISRs hand their
+// samples and button events over through rings (ring.h)
+
 // Variable that holds the state of the device
-volatile device_state_t device_state;
+device_state_t device_state;
 
-// Variables to implement delay between states and vibration
-volatile uint32_t button_press_time = 0; // Time of the button press
-volatile bool state_change_pending = false; // Flag for pending state change
-volatile device_state_t next_state; // Holds the next state to switch to
-volatile uint32_t vibrate_start_time = 0; // Time for when the vibration starts
-volatile bool is_vibrating = false; //  Flag for vibration
-volatile bool automatic_transition = 0; // Flag for automatic transitions
+// Variables to implement delay between states
+uint32_t button_press_time = 0; // Time of the button press
+const uint16_t transition_delay[DEVICE_STATE_COUNT] = { // Delay in ms before a button transition out of a state
+    DELAY_ON_MS, // ON
+    0, // INITIALIZATION, ends by itself
+    DELAY_READING_MS, // READING
+    DELAY_HRBO_MS, // HRBO
+    0 // TRANSMIT, ends by itself
+};
+bool state_change_pending = false; // Flag for pending state change
+device_state_t next_state; // Holds the next state to switch to
+bool automatic_transition = 0; // Flag for automatic transitions
 
 // Variables for muscle sensor data
-volatile uint32_t initialization_start_time = 0; // Start time of the INITIALIZATION state
-volatile uint32_t muscle_sum = 0; // Sum of muscle sensor readings
-volatile uint32_t muscle_samples = 0; // Number of muscle sensor samples
-volatile uint32_t baseline_muscle_average = 0; // Baseline average muscle reading
-volatile uint32_t muscle_average = 0; // Average muscle reading
+uint32_t initialization_start_time = 0; // Start time of the INITIALIZATION state
+stats_t muscle_stats; // Statistics of the muscle sensor readings
+uint32_t baseline_muscle_average = 0; // Baseline average muscle reading
+uint32_t muscle_average = 0; // Average muscle reading
 
 // Variables for calculating heart rate
-volatile float average_bpm = 0; // Average beats per minute
-volatile float blood_oxygen = 0; // Average blood oxygen level
-volatile long lastBeat = 0; // Time since the last beat
-volatile float beatsPerMinute = 0; // Current beats per minute
-volatile uint8_t rates[RATE_SIZE] = {0}; // Buffer for averaging
-volatile uint8_t rateSpot = 0; // Index in rates buffer
-volatile uint32_t ir_start_time = 0; // Time when red value exceeded threshold
-volatile bool ir_below_threshold = false; // Tracks if red value is above threshold
+float average_bpm = 0; // Average beats per minute
+float blood_oxygen = 0; // Average blood oxygen level
+long lastBeat = 0; // Time since the last beat
+uint32_t ir_start_time = 0; // Time when red value exceeded threshold
+bool ir_below_threshold = false; // Tracks if red value is above threshold
+
+// Next set of the session to send over BLE, past the last set the
+// diagnostics and energy records follow
+uint8_t transmit_index = 0;
 
-// Buffer for storing the data to send over BLE
-volatile uint16_t data_to_send[4];
+// Calibration loaded from EEPROM at startup
+calibration_t calibration;
 
-// Amount of time in the READING state
-volatile uint32_t reading_time = 0;
+// Amount of time in the READING state and when the set started
+uint32_t reading_time = 0;
+uint32_t set_start_time = 0;
 
 // Variable to hold milliseconds since startup
 volatile uint32_t milliseconds = 0;
 
 /**
-* Initialize the vibrating peripheral
-*/
-void vibration_init() {
-   PORTA.DIR |= PIN5_bm;
-}
-
-/**
-* Starts the vibrating peripheral
+* Runs the CPU at F_CPU (20 MHz oscillator divided by 2) instead of the
+* default divide by 6
 */
-void start_vibration() {
-   PORTA.OUTSET = PIN5_bm; // Set A5 high
-   vibrate_start_time = millis();  // Record the start time
-   is_vibrating = true; // Mark vibration as active
-}
-
-/**
-* Checks if the device is vibrating and cancels it after 500 ms
-*/
-void check_vibrate() {
-   if (is_vibrating) {
-       // Check if 500 ms have elapsed
-       if (millis() - vibrate_start_time >= 500) {
-           PORTA.OUTCLR = PIN5_bm; // Set A5 low (turn off output)
-           is_vibrating = false; // Reset the state
-       }
-   }
+void clock_init(void) {
+   _PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, CLKCTRL_PDIV_2X_gc | CLKCTRL_PEN_bm);
 }
 
 /**
@@ -77,40 +65,71 @@ void RTC_init(void) {
    // Select RTC clock source
    RTC.CLKSEL = RTC_CLKSEL_INT32K_gc;
 
-   // Configure RTC: Enable, run in standby, prescaler = 32 so 1024 Hz
-   RTC.CTRLA = RTC_PRESCALER_DIV32_gc | RTC_RUNSTDBY_bm | RTC_RTCEN_bm;
+   // Wait for the RTC registers to be synchronized before writing them
+   while (RTC.STATUS > 0) {;}
+
+   // Start from zero
+   RTC.CNT = 0;
+
+   // Interrupt every second (the counter runs from 0 to PER)
+   RTC.PER = 1023;
 
    // Enable overflow interrupt
    RTC.INTCTRL = RTC_OVF_bm;
 
-   // Start from zero
-   RTC.CNT = 0;
-   
-   // Interrupt every second
-   RTC.PER = 1024;
+   // Configure RTC: Enable, run in standby, prescaler = 32 so 1024 Hz
+   RTC.CTRLA = RTC_PRESCALER_DIV32_gc | RTC_RUNSTDBY_bm | RTC_RTCEN_bm;
+}
+
+/**
+* Get the time since startup
+* @return milliseconds since startup
+*/
+uint32_t millis() {
+   uint32_t ms;
+   uint16_t count;
+
+   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+       ms = milliseconds;
+       count = RTC.CNT;
+
+       // The counter may have wrapped before the overflow interrupt ran
+       if (RTC.INTFLAGS & RTC_OVF_bm) {
+           ms += 1000;
+           count = RTC.CNT;
+       }
+   }
+
+   // Counter ticks at 1024 Hz
+   return ms + (((uint32_t)count * 1000) >> 10);
 }
 
 /**
 * Collects the muscle data from the muscle sensor peripheral
 * @param average holds the average reading for the muscle sensor
 * @param timed if the function should run for 3 seconds or until state change
+* @param emg_val muscle sensor reading from the acquisition stream
 */
-void collect_muscle_data(uint32_t *average, bool timed) {
+void collect_muscle_data(uint32_t *average, bool timed, uint16_t emg_val) {
    // Start initialization process
    if (initialization_start_time == 0) {
        initialization_start_time = millis(); // Record the start time
-       muscle_sum = 0;
-       muscle_samples = 0;
+       stats_reset(&muscle_stats);
    }
 
 
    // If timed is true and 3 seconds have elapsed, finalize data collection,
    // otherwise a button press will end this looping
    if (timed && millis() - initialization_start_time >= 3000) {
-        if (muscle_samples > 0) {
-            *average = muscle_sum / muscle_samples; // Update the variable passed as an argument
+        if (stats_count(&muscle_stats) > 0) {
+            *average = stats_mean(&muscle_stats); // Update the variable passed as an argument
             set_LED_color(0, 1, 0);
-            start_vibration();
+            feedback_play_motor(fx_state_change, false);
+
+            // Remember the baseline so later sessions can skip this state
+            calibration.emg_baseline = *average;
+            calibration_save(&calibration);
+            baseline_set(*average);
         } else {
             *average = 0; // Set to 0 if no samples were collected
         }
@@ -119,52 +138,90 @@ void collect_muscle_data(uint32_t *average, bool timed) {
         next_state = ON;
         automatic_transition = true;
    } else {
-       muscle_sum += ADC_read();
-       muscle_samples++;
+       stats_add(&muscle_stats, emg_val);
+
+       // Keep the average current without dividing on every sample
+       if (!timed && (stats_count(&muscle_stats) & 0x3F) == 0) {
+           *average = stats_mean(&muscle_stats);
+           show_effort(*average);
+       }
+   }
+}
+
+/**
+* Shows the effort of the set as the brightness of the blue LED, reaching
+* full brightness at twice the resting baseline
+* @param average current average muscle reading
+*/
+void show_effort(uint32_t average) {
+   uint32_t level = 255;
+
+   if (baseline_muscle_average > 0) {
+       level = average * 128 / baseline_muscle_average;
+   }
+   feedback_set_brightness(level > 255 ? 255 : level < 16 ? 16 : level);
+}
+
+/**
+* Follows the resting muscle level between reps and after the set
+* @param emg_val muscle sensor reading from the acquisition stream
+*/
+void track_baseline(uint16_t emg_val) {
+   if (baseline_update(emg_val)) {
+       baseline_muscle_average = baseline_get();
    }
 }
 
 /**
 * Updates the variables passed in with the correct data for the HR and BO
+* @param sample PPG sample from the acquisition stream
 * @param average_bpm variable to hold the average beats per minute
 * @param blood_oxygen variable to hold the average blood oxygen
 */
-void sense_HRBO(float *average_bpm, float *blood_oxygen) {
-   MAX30102_sample_t sample;
-   MAX30102_get_sample(&sample);
+void sense_HRBO(const acq_sample_t *sample, float *average_bpm, float *blood_oxygen) {
+   // The sample carries the EMG from the same period, use it to cancel the
+   // motion artifacts it predicts from both PPG channels
+   motion_reference_update(sample->emg);
+   uint32_t ir = motion_cancel(MOTION_IR, sample->ir);
+   uint32_t red = motion_cancel(MOTION_RED, sample->red);
 
    // Heart rate calculation
-   if (check_for_beat(sample.ir)) {
-       uint32_t delta = millis() - lastBeat;
-       lastBeat = millis();
+   bool beat = check_for_beat(ir);
+   bool keep = false;
 
-       beatsPerMinute = 60 / (delta / 1000.0);
+   // Score the signal, using the raw readings so clipping is visible
+   sqi_update(sample->ir, sample->red, get_IR_AC_signal(), beat);
 
-       if (beatsPerMinute < 255 && beatsPerMinute > 20) {
-           rates[rateSpot++] = (uint8_t)beatsPerMinute;
-           rateSpot %= RATE_SIZE;
+   if (beat) {
+       uint32_t delta = sample->timestamp - lastBeat;
+       lastBeat = sample->timestamp;
 
-           // Calculate the average BPM
-           *average_bpm = 0;
-           for (uint8_t i = 0; i < RATE_SIZE; i++) {
-               *average_bpm += rates[i];
-           }
-           *average_bpm /= RATE_SIZE;
-           // Blood oxygen calculation
-           calculate_and_update_spo2(&blood_oxygen, sample.ir, sample.red);
+       // Only let beats from a good quality window update HR and SpO2
+       if (sqi_is_good() && average_beat(delta, average_bpm)) {
+           keep = true;
+
+           // Standard receivers get every beat as it happens
+           heart_rate_beat(*average_bpm + 0.5f, delta);
        }
    }
 
-   // Transition to TRANSMIT state if red value < 50000 for 3 seconds
-   if (sample.ir < 50000) {
+   // Blood oxygen calculation, measured over every cycle and updated from
+   // the same beats as the heart rate
+   calculate_and_update_spo2(ir, red, beat, keep, blood_oxygen);
+
+   // End the set if red value < 50000 for 3 seconds, only once the set is
+   // over
+   if (device_state != HRBO) {
+       return;
+   }
+   if (sample->ir < 50000) {
         if (!ir_below_threshold) {
             ir_start_time = millis(); // Start timing
             ir_below_threshold = true;
         } else if (millis() - ir_start_time >= 3000) {
-            set_LED_color(1, 0, 1); // Set LED to Purple
             ir_below_threshold = false; // Reset tracking
             ir_start_time = 0;
-            next_state = TRANSMIT; // Transition to TRANSMIT state
+            next_state = ON; // Wait for the next set
             automatic_transition = true;
         }
    } else {
@@ -174,6 +231,164 @@ void sense_HRBO(float *average_bpm, float *blood_oxygen) {
    }
 }
 
+/**
+* Hands the samples collected since the last call to the current state
+*/
+void process_samples() {
+   acq_sample_t sample;
+
+   // Bounded so state changes are still picked up between batches
+   for (uint8_t i = 0; i < ACQ_EMG_BUFFER && !automatic_transition; i++) {
+       if (!acquisition_next(&sample)) {
+           break;
+       }
+       if (sample.type == ACQ_EMG) {
+           if (device_state == INITIALIZATION) {
+               collect_muscle_data(&baseline_muscle_average, true, sample.emg);
+           } else if (device_state == READING) {
+               collect_muscle_data(&muscle_average, false, sample.emg);
+               fatigue_add(sample.emg);
+               track_baseline(sample.emg);
+           } else if (device_state == HRBO) {
+               track_baseline(sample.emg);
+           }
+       } else {
+           sense_HRBO(&sample, &average_bpm, &blood_oxygen);
+       }
+   }
+}
+
+/**
+* Starts sampling the sensors needed by a state
+* @param state state being entered
+*/
+void start_state_acquisition(device_state_t state) {
+   switch (state) {
+       case INITIALIZATION:
+           acquisition_start(ACQ_EMG);
+           break;
+       case READING:
+       case HRBO:
+           // Heart rate is followed during the set as well as after it
+           acquisition_start(ACQ_EMG | ACQ_PPG);
+           break;
+       default:
+           acquisition_stop();
+           break;
+   }
+}
+
+/**
+* Hands a snapshot of the set in progress to the live telemetry
+*/
+void publish_telemetry() {
+   telemetry_t snapshot;
+
+   snapshot.state = device_state;
+   snapshot.bpm = average_bpm;
+   snapshot.spo2 = blood_oxygen;
+   snapshot.quality = sqi_get_quality();
+   for (uint8_t i = 0; i < EMG_CHANNELS; i++) {
+       snapshot.envelope[i] = acquisition_emg_envelope(i);
+   }
+   snapshot.median_freq = fatigue_get()->median;
+   telemetry_update(&snapshot);
+}
+
+/**
+* Stores the set that just ended in the session and gets ready for the next
+*/
+void finish_set() {
+   session_set_t set;
+
+   // Every reading of the set, muscle_average leaves out the open block
+   uint16_t emg_mean = stats_count(&muscle_stats) > 0 ? stats_mean(&muscle_stats) : 0;
+
+   set.start = set_start_time;
+   set.duration = reading_time / 1000;
+   set.emg_average = emg_mean;
+   set.emg_deviation = stats_deviation(&muscle_stats);
+   set.emg_peak = muscle_stats.max;
+   set.intensity = stats_ratio(emg_mean, baseline_muscle_average, 1000);
+   set.bpm = average_bpm;
+   set.spo2 = blood_oxygen;
+   set.quality = sqi_get_session_quality();
+   set.fatigue_slope = fatigue_get()->slope;
+   session_add(&set);
+
+   // Keep the resting level the session drifted to for the next power-up
+   if (abs((int16_t)baseline_muscle_average - (int16_t)calibration.emg_baseline) >= BASELINE_SAVE_DELTA) {
+       calibration.emg_baseline = baseline_muscle_average;
+       calibration_save(&calibration);
+   }
+
+   reset_math_globals();
+   reset_motion_globals();
+   reset_sqi_globals();
+   reset_fatigue_globals();
+   reset_globals();
+}
+
+/**
+* Uploads the session over BLE one set per call, without waiting on the
+* module. The session is only cleared once everything is sent.
+*/
+void transmit_data() {
+   bool ble_failed = BLE_get_state() == BLE_FAILED;
+   if (transmit_index < session_size() && !ble_failed) {
+       session_set_t set;
+       session_get(transmit_index, &set);
+       if (BLE_send_data(BLE_ACTIVITY_HANDLE, (const uint8_t *)&set, SESSION_SET_SIZE)) {
+           transmit_index++;
+       }
+       return;
+   }
+
+   // Follow the sets with the diagnostics record
+   if (transmit_index == session_size() && !ble_failed) {
+       diagnostics_t diag;
+       diagnostics_collect(&diag);
+       if (BLE_send_data(BLE_DIAGNOSTICS_HANDLE, (const uint8_t *)&diag, sizeof(diag))) {
+           transmit_index++;
+       }
+       return;
+   }
+   if (transmit_index == session_size() + 1 && !ble_failed) {
+       energy_record_t energy;
+       energy_collect(&energy);
+       if (BLE_send_data(BLE_ENERGY_HANDLE, (const uint8_t *)&energy, sizeof(energy))) {
+           transmit_index++;
+       }
+       return;
+   }
+
+   // Wait for the module to acknowledge the last value
+   if (!BLE_is_ready() && !ble_failed) {
+       return;
+   }
+
+   // Keep the sets for another try if the module is gone
+   if (!ble_failed) {
+       session_clear();
+       energy_clear();
+   }
+   transmit_index = 0;
+   set_LED_color(0, 1, 0); // Set color to green
+   next_state = ON;
+   automatic_transition = true;
+}
+
+/**
+* Hands the loaded calibration to the modules that use it
+*/
+void apply_calibration() {
+   baseline_muscle_average = calibration.emg_baseline;
+   baseline_set(calibration.emg_baseline);
+   set_spo2_coefficients(calibration.spo2_a / 100.0, calibration.spo2_b / 100.0);
+   set_beat_thresholds(calibration.beat_min, calibration.beat_max);
+   MAX30102_set_led_amplitudes(calibration.red_amplitude, calibration.ir_amplitude);
+}
+
 /**
  * Resets all the variables that need to be rest in between readings
  */
@@ -183,47 +398,61 @@ void reset_globals() {
     blood_oxygen = 0;
     reading_time = 0;
     lastBeat = 0;
-    beatsPerMinute = 0;
-    rateSpot = 0;
     ir_start_time = 0;
     ir_below_threshold = false;
     initialization_start_time = 0;
-    for (uint8_t i = 0; i < RATE_SIZE; i++) {
-        rates[i] = 0;
-    }
 }
 /**
-* Port interrupt service routine for button press/release
+* Acts on the button gestures queued by the button module. A short press
+* schedules the next state after the delay for the current state, a double
+* press takes the scheduled state right away and a long press cancels it.
+* With nothing scheduled, a long press in ON toggles capture mode (red) or
+* uploads the session (yellow).
 */
-ISR(PORTA_PORT_vect) {
-   if (RED_BUTTON_INTERRUPT) {
-       if (device_state == ON && !state_change_pending) {
-           button_press_time = millis(); // Record button press time
-           next_state = INITIALIZATION; // Set the next state
-           state_change_pending = true; // Indicate a pending state change
-       }
-       RED_BUTTON_INTERRUPT_CLEAR;
-   }
+void handle_button_events() {
+   uint8_t button;
+   button_gesture_t gesture;
 
-   if (YELLOW_BUTTON_INTERRUPT) {
-       if ((device_state == ON || device_state == READING || device_state == HRBO) && !state_change_pending) {
-           state_change_pending = true; // Indicate a pending state change
-           button_press_time = millis(); // Record button press time
-           switch (device_state) {
-               case ON:
-                   next_state = READING;
-                   reading_time = millis();
+   while (button_get_event(&button, &gesture)) {
+       switch (gesture) {
+           case BUTTON_SHORT:
+               if (state_change_pending) {
                    break;
-               case READING:
+               }
+               if (button == BUTTON_RED && device_state == ON) {
+                   next_state = INITIALIZATION;
+               } else if (button == BUTTON_YELLOW && device_state == ON) {
+                   next_state = READING;
+               } else if (button == BUTTON_YELLOW && device_state == READING) {
                    next_state = HRBO;
-                   reading_time = millis() - reading_time;
+               } else if (button == BUTTON_YELLOW && device_state == HRBO) {
+                   next_state = ON; // End the set
+               } else {
                    break;
-               case HRBO:
+               }
+               button_press_time = millis(); // Record button press time
+               state_change_pending = true; // Indicate a pending state change
+               break;
+           case BUTTON_DOUBLE:
+               // The first press already scheduled the state, skip the delay
+               if (state_change_pending) {
+                   automatic_transition = true;
+               }
+               break;
+           case BUTTON_LONG:
+               if (state_change_pending) {
+                   state_change_pending = false;
+               } else if (button == BUTTON_RED && device_state == ON) {
+                   // Raw sample capture for the following sessions
+                   capture_enable(!capture_is_enabled());
+                   feedback_play_motor(fx_double_buzz, false);
+               } else if (button == BUTTON_YELLOW && device_state == ON) {
+                   // Upload every set of the session
                    next_state = TRANSMIT;
-                   break;
-           }
+                   automatic_transition = true;
+               }
+               break;
        }
-       YELLOW_BUTTON_INTERRUPT_CLEAR;
    }
 }
 
@@ -240,14 +469,19 @@ ISR(RTC_CNT_vect) {
 * Main function to initialize and run the code
 */
 int main() {
-   // Initializations
+   // Initializations, BLE_init() only starts the module bring-up which
+   // continues in the background once interrupts are enabled
+   clock_init();
    USART_init();
+   capture_init();
    RTC_init();
    ADC_init();
    MAX30102_init();
    MAX30102_setup();
+   calibration_load(&calibration);
+   apply_calibration();
+   session_init();
    button_init();
-   vibration_init();
    LED_init();
    BLE_init("FitDev");
    
@@ -257,14 +491,34 @@ int main() {
    // Initialize to ON state;
    device_state = ON;
    set_LED_color(0, 1, 0); // Green
+   energy_init(device_state);
 
    while (1) {
+       handle_button_events();
+
        // Check if a state change is pending and if the delay has elapsed
-       if ((state_change_pending && (millis() - button_press_time >= 3000)) || automatic_transition) {
+       if ((state_change_pending && (millis() - button_press_time >= transition_delay[device_state])) || automatic_transition) {
+            // Time the set from entering READING to leaving it
+            if (device_state == READING && next_state != READING) {
+                reading_time = millis() - reading_time;
+            } else if (device_state != READING && next_state == READING) {
+                reading_time = millis();
+                set_start_time = reading_time;
+            }
+
+            // The set is over once HRBO is left
+            if (device_state == HRBO && next_state != HRBO) {
+                finish_set();
+            }
+
             device_state = next_state; // Switch to the next state
+            energy_set_state(device_state);
             state_change_pending = false; // Reset the flag
             automatic_transition = false;
-            start_vibration();
+            feedback_play_motor(fx_state_change, false);
+            start_state_acquisition(device_state);
+            telemetry_enable(device_state == READING || device_state == HRBO);
+            heart_rate_enable(device_state == READING || device_state == HRBO);
 
             // Change the LED based on the new state
             switch (device_state) {
@@ -285,34 +539,31 @@ int main() {
                     break;
             }
         }
-       // Check if the device should vibrate
-       check_vibrate();
+       // Keep the BLE bring-up and any command in flight moving
+       BLE_task();
+       heart_rate_task();
+       telemetry_task();
        
        // General brains of the code to determine what to do in each state
        switch (device_state) {
            case ON:
                break;
            case INITIALIZATION:
-               collect_muscle_data(&baseline_muscle_average, true);
-               break;
            case READING:
-               collect_muscle_data(&muscle_average, false);
-               break;
            case HRBO:
-               sense_HRBO(&average_bpm, &blood_oxygen);
+               process_samples();
+               if (telemetry_due()) {
+                   publish_telemetry();
+               }
                break;
            case TRANSMIT:
-               data_to_send[0] = muscle_average/baseline_muscle_average*100;
-               data_to_send[1] = average_bpm;
-               data_to_send[2] = blood_oxygen;
-               data_to_send[3] = reading_time / 1000;
-               BLE_send_data(data_to_send, 4);
-               set_LED_color(0, 1, 0); // Set color to green
-               next_state = ON;
-               automatic_transition = true;
-               reset_math_globals();
-               reset_globals();
+               transmit_data();
                break;
        }
+
+       // Nothing left to do until the next interrupt
+       if (!automatic_transition) {
+           energy_idle();
+       }
    }
 }
@@ -4,18 +4,32 @@
 #include <string.h>
 #include <stdio.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include "muscle.h"
 #include "max30102.h"
 #include "bluetooth.h"
 #include "button_led.h"
 #include "max30102_math.h"
+#include "motion_filter.h"
+#include "signal_quality.h"
+#include "acquisition.h"
+#include "calibration.h"
+#include "diagnostics.h"
+#include "capture.h"
+#include "session.h"
+#include "telemetry.h"
+#include "stats.h"
+#include "fatigue.h"
+#include "energy.h"
+#include "baseline.h"
+#include "heart_rate.h"
 
 #ifndef NEWAVIR_MAIN_H
 #define	NEWAVIR_MAIN_H
 
 // Definitions for keep track of time
 extern volatile uint32_t milliseconds;
-#define millis() (milliseconds + RTC.CNT)
+uint32_t millis();
 
 // Struct for states
 typedef enum {
@@ -25,20 +39,34 @@ typedef enum {
     HRBO,
     TRANSMIT
 } device_state_t;
+#define DEVICE_STATE_COUNT 5
 
-// Vibration functions
-void vibration_init();
-void check_vibrate();
-void start_vibration();
+// Delay from a short press to leaving a state. A long press cancels the
+// change while it waits, so each delay leaves room for one (BUTTON_LONG_TICKS
+// after the short press is recognised).
+#define DELAY_ON_MS 3000 // Time to get into position before the set starts
+#define DELAY_READING_MS 1500 // Ends the set close to the press, before the weight is put down
+#define DELAY_HRBO_MS 3000 // Time to take the finger off the sensor
 
 // Functions to access peripherals
-void collect_muscle_data(uint32_t *average, bool timed);
-void sense_HRBO(float *average_bpm, float *blood_oxygen);
+void collect_muscle_data(uint32_t *average, bool timed, uint16_t emg_val);
+void show_effort(uint32_t average);
+void track_baseline(uint16_t emg_val);
+void sense_HRBO(const acq_sample_t *sample, float *average_bpm, float *blood_oxygen);
+void process_samples();
+void start_state_acquisition(device_state_t state);
+void publish_telemetry();
+void finish_set();
+void transmit_data();
+void apply_calibration();
 void reset_globals();
 
+// Button functions
+void handle_button_events();
+
 // Interrupt and timer functions
+void clock_init(void);
 void RTC_init(void);
-ISR(PORTA_PORT_vect);
 ISR(RTC_CNT_vect);
 
 // Main function
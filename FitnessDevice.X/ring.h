@@ -0,0 +1,140 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef RING_H
+#define	RING_H
+
+/*
+ * Single-producer single-consumer ring for handing records between an ISR
+ * and the main loop without disabling interrupts. The producer only writes
+ * head and the consumer only writes tail. Both are free running 8-bit
+ * counters, so reading or writing one is a single atomic load or store. An
+ * item is written before the head that publishes it is stored (release) and
+ * read after the head is loaded (acquire), and the same holds for the tail
+ * in the other direction. The operations are inline so an ISR pays no more
+ * than for a hand written buffer.
+ *
+ * Producer: ring_slot(), fill the item, ring_commit() (or ring_push())
+ * Consumer: ring_front(), use the item, ring_drop() (or ring_pop())
+ */
+
+// Ring over a buffer of item_size byte items, size is a power of two of at
+// most 128 so the counters can tell full from empty
+typedef struct {
+    uint8_t head; // Items published, only written by the producer
+    uint8_t tail; // Items consumed, only written by the consumer
+    uint8_t mask; // Size - 1
+    uint8_t item_size;
+    uint8_t *items;
+} ring_t;
+
+// Define a ring called name with its buffer of size items of type
+#define RING_DEFINE(name, type, size) \
+    typedef char name##_size_check[((size) & ((size) - 1)) == 0 && (size) <= 128 ? 1 : -1]; \
+    type name##_items[size]; \
+    ring_t name = {0, 0, (size) - 1, sizeof(type), (uint8_t *)name##_items}
+
+/**
+ * Empty the ring, only while neither side is using it
+ * @param ring ring to empty
+ */
+static inline void ring_reset(ring_t *ring) {
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+/**
+ * Get the number of items waiting, exact for either side
+ * @param ring ring to check
+ * @return items published and not yet consumed
+ */
+static inline uint8_t ring_count(const ring_t *ring) {
+    return (uint8_t)(__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+}
+
+/**
+ * Get the number of free items, for the producer
+ * @param ring ring to check
+ * @return items that can be pushed before the ring is full
+ */
+static inline uint8_t ring_space(const ring_t *ring) {
+    return ring->mask + 1 - ring_count(ring);
+}
+
+/**
+ * Get the slot the producer fills next
+ * @param ring ring to write
+ * @return pointer to the item, NULL if the ring is full
+ */
+static inline void *ring_slot(ring_t *ring) {
+    uint8_t head = ring->head;
+    if ((uint8_t)(head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) > ring->mask) {
+        return NULL;
+    }
+    return ring->items + (size_t)(head & ring->mask) * ring->item_size;
+}
+
+/**
+ * Publish the slot from ring_slot() to the consumer
+ * @param ring ring to write
+ */
+static inline void ring_commit(ring_t *ring) {
+    __atomic_store_n(&ring->head, (uint8_t)(ring->head + 1), __ATOMIC_RELEASE);
+}
+
+/**
+ * Get the oldest item for the consumer
+ * @param ring ring to read
+ * @return pointer to the item, NULL if the ring is empty
+ */
+static inline void *ring_front(ring_t *ring) {
+    uint8_t tail = ring->tail;
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+        return NULL;
+    }
+    return ring->items + (size_t)(tail & ring->mask) * ring->item_size;
+}
+
+/**
+ * Hand the item from ring_front() back to the producer
+ * @param ring ring to read
+ */
+static inline void ring_drop(ring_t *ring) {
+    __atomic_store_n(&ring->tail, (uint8_t)(ring->tail + 1), __ATOMIC_RELEASE);
+}
+
+/**
+ * Copy an item into the ring
+ * @param ring ring to write
+ * @param item item of item_size bytes
+ * @return true if pushed, false if the ring is full
+ */
+static inline bool ring_push(ring_t *ring, const void *item) {
+    void *slot = ring_slot(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(slot, item, ring->item_size);
+    ring_commit(ring);
+    return true;
+}
+
+/**
+ * Copy the oldest item out of the ring
+ * @param ring ring to read
+ * @param item where to put the item
+ * @return true if an item was popped, false if the ring is empty
+ */
+static inline bool ring_pop(ring_t *ring, void *item) {
+    const void *front = ring_front(ring);
+    if (front == NULL) {
+        return false;
+    }
+    memcpy(item, front, ring->item_size);
+    ring_drop(ring);
+    return true;
+}
+
+#endif	/* RING_H */
@@ -0,0 +1,62 @@
+#include "scratch.h"
+/*
+ * Scratch arena for buffers that only live for one phase of work, such as
+ * formatting a BLE command or encoding a block of samples. Instead of each
+ * function putting its own buffer on the stack they take it from here with
+ * a bump allocator and hand the whole phase back at once:
+ *
+ *     scratch_mark_t mark = scratch_begin();
+ *     char *command = scratch_alloc(20);
+ *     ...
+ *     scratch_end(mark);
+ *
+ * Phases can nest as long as they end in reverse order. The arena is only
+ * for the main loop, interrupts must not use it.
+ */
+
+uint8_t scratch_arena[SCRATCH_SIZE];
+uint8_t scratch_top = 0; // Bytes handed out
+uint8_t scratch_high = 0; // Most bytes ever handed out at once
+
+/**
+ * Start a phase of scratch use
+ * @return mark to hand to scratch_end()
+ */
+scratch_mark_t scratch_begin() {
+    return scratch_top;
+}
+
+/**
+ * Take a buffer from the arena
+ * @param size bytes needed
+ * @return the buffer, NULL if the arena does not have enough room
+ */
+void *scratch_alloc(uint8_t size) {
+    if (size > SCRATCH_SIZE - scratch_top) {
+        return NULL;
+    }
+    void *buffer = &scratch_arena[scratch_top];
+    scratch_top += size;
+    if (scratch_top > scratch_high) {
+        scratch_high = scratch_top;
+    }
+    return buffer;
+}
+
+/**
+ * End a phase, everything allocated since its scratch_begin() is released
+ * @param mark value returned by scratch_begin()
+ */
+void scratch_end(scratch_mark_t mark) {
+    if (mark < scratch_top) {
+        scratch_top = mark;
+    }
+}
+
+/**
+ * Get the most of the arena ever in use, for sizing SCRATCH_SIZE
+ * @return peak bytes in use
+ */
+uint8_t scratch_peak() {
+    return scratch_high;
+}
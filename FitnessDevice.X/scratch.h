@@ -0,0 +1,19 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SCRATCH_H
+#define	SCRATCH_H
+
+// Size of the arena shared by the short lived buffers of the main loop
+#define SCRATCH_SIZE 64
+
+// Position in the arena to return to when a phase is done
+typedef uint8_t scratch_mark_t;
+
+scratch_mark_t scratch_begin();
+void *scratch_alloc(uint8_t size);
+void scratch_end(scratch_mark_t mark);
+uint8_t scratch_peak();
+
+#endif	/* SCRATCH_H */
+
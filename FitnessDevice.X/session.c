@@ -0,0 +1,121 @@
+#include "session.h"
+/*
+ * A workout session made of many sets that is uploaded in one TRANSMIT.
+ * Finished sets go into a RAM ring of SESSION_SETS records. When the ring is
+ * full the oldest record is written to the next free EEPROM slot, so a long
+ * session keeps its sets and the ones in EEPROM survive a power cycle (their
+ * start times are from the power-up they were recorded in). Slots fill from
+ * the first one and are only freed together after an upload, so slot order
+ * is set order. A slot is in use while its record has a valid CRC. With RAM
+ * and EEPROM both full the oldest set in RAM is lost.
+ */
+
+session_set_t EEMEM session_eeprom[SESSION_SPILL_SETS];
+
+// RAM ring, oldest set at session_head
+session_set_t session_ring[SESSION_SETS];
+uint8_t session_head = 0;
+uint8_t session_count = 0;
+
+// EEPROM slots in use and the number the next set gets
+uint8_t session_spilled = 0;
+uint8_t session_next_number = 0;
+
+/**
+ * Compute the CRC of a set
+ * @param set record to check
+ * @return CRC-16/CCITT of the record without its crc field
+ */
+static uint16_t session_crc(const session_set_t *set) {
+    const uint8_t *data = (const uint8_t *)set;
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < SESSION_SET_SIZE; i++) {
+        crc = _crc_ccitt_update(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * Pick up the sets left in EEPROM by an earlier power-up
+ */
+void session_init() {
+    session_set_t set;
+
+    session_head = 0;
+    session_count = 0;
+    session_spilled = 0;
+    while (session_spilled < SESSION_SPILL_SETS) {
+        eeprom_read_block(&set, &session_eeprom[session_spilled], sizeof(set));
+        if (set.crc != session_crc(&set)) {
+            break;
+        }
+        session_next_number = set.number + 1;
+        session_spilled++;
+    }
+}
+
+/**
+ * Add a finished set to the session
+ * @param set record to add, its number is filled in
+ */
+void session_add(session_set_t *set) {
+    set->number = session_next_number++;
+
+    // Make room by moving the oldest set to EEPROM
+    if (session_count == SESSION_SETS) {
+        session_set_t *oldest = &session_ring[session_head];
+        if (session_spilled < SESSION_SPILL_SETS) {
+            oldest->crc = session_crc(oldest);
+            eeprom_update_block(oldest, &session_eeprom[session_spilled], sizeof(*oldest));
+            session_spilled++;
+        }
+        session_head = (session_head + 1) % SESSION_SETS;
+        session_count--;
+    }
+
+    session_ring[(session_head + session_count) % SESSION_SETS] = *set;
+    session_count++;
+}
+
+/**
+ * Get the number of sets waiting to be uploaded
+ * @return sets in EEPROM and RAM
+ */
+uint8_t session_size() {
+    return session_spilled + session_count;
+}
+
+/**
+ * Get a set of the session, oldest first
+ * @param index position in the session, 0 is the oldest set
+ * @param set where to put the record
+ * @return true if the set exists
+ */
+bool session_get(uint8_t index, session_set_t *set) {
+    if (index < session_spilled) {
+        eeprom_read_block(set, &session_eeprom[index], sizeof(*set));
+        return true;
+    }
+    index -= session_spilled;
+    if (index >= session_count) {
+        return false;
+    }
+    *set = session_ring[(session_head + index) % SESSION_SETS];
+    return true;
+}
+
+/**
+ * Forget every set once the session is uploaded
+ */
+void session_clear() {
+    session_set_t set;
+
+    // Break the CRC of each used slot so it reads as free
+    for (uint8_t i = 0; i < session_spilled; i++) {
+        eeprom_read_block(&set, &session_eeprom[i], sizeof(set));
+        eeprom_update_word(&session_eeprom[i].crc, session_crc(&set) ^ 0xFFFF);
+    }
+    session_spilled = 0;
+    session_head = 0;
+    session_count = 0;
+}
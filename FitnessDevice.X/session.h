@@ -0,0 +1,43 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "bluetooth.h"
+
+#ifndef SESSION_H
+#define	SESSION_H
+
+// Sets kept in RAM, the oldest moves to EEPROM when another one is added
+#define SESSION_SETS 8
+
+// EEPROM slots for sets pushed out of RAM
+#define SESSION_SPILL_SETS 8
+
+// One finished set, uploaded over BLE as its first SESSION_SET_SIZE bytes
+// (little endian, without the CRC)
+typedef struct {
+    uint8_t number; // Counts up over the sets, wraps at 256
+    uint32_t start; // ms since power-on when the set started
+    uint16_t duration; // Seconds in the READING state
+    uint16_t emg_average; // Average muscle reading over the set
+    uint16_t emg_deviation; // Standard deviation of the muscle reading
+    uint16_t emg_peak; // Highest muscle reading
+    uint16_t intensity; // emg_average relative to the resting baseline in 0.1%
+    uint8_t bpm; // Average heart rate after the set
+    uint8_t spo2; // Blood oxygen after the set
+    uint8_t quality; // Session signal quality 0-100
+    int16_t fatigue_slope; // Change of the EMG median frequency in 0.01 Hz/s
+    uint16_t crc; // CRC-16/CCITT of everything above, kept for EEPROM slots
+} session_set_t;
+#define SESSION_SET_SIZE offsetof(session_set_t, crc)
+
+typedef char session_set_size_check[SESSION_SET_SIZE <= BLE_MAX_DATA ? 1 : -1];
+
+void session_init();
+void session_add(session_set_t *set);
+uint8_t session_size();
+bool session_get(uint8_t index, session_set_t *set);
+void session_clear();
+
+#endif	/* SESSION_H */
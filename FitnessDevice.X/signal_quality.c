@@ -0,0 +1,255 @@
+#include "signal_quality.h"
+/*
+ * Streaming signal quality index (SQI) for the PPG signal. Every SQI_WINDOW
+ * samples the window is scored on:
+ *  - perfusion index (IR AC peak-to-peak over DC)
+ *  - red/IR AC/DC ratio being physiologically possible
+ *  - clipping of the raw readings
+ *  - consistency of the beat intervals
+ *  - correlation of each beat with a running beat template
+ * The overall quality is the weakest of these scores, so one bad property is
+ * enough to reject a window.
+ */
+
+// Accumulators for the current window
+uint8_t sqi_count = 0;
+uint8_t sqi_clipped = 0;
+uint32_t sqi_ir_min = 0, sqi_ir_max = 0, sqi_red_min = 0, sqi_red_max = 0;
+uint32_t sqi_ir_sum = 0, sqi_red_sum = 0;
+
+// Beat interval tracking (in samples)
+uint16_t sqi_samples_since_beat = 0;
+uint16_t sqi_interval_average = 0;
+uint8_t sqi_windows_without_beat = 0;
+bool sqi_beat_seen = false;
+
+// Beat morphology: history of the AC signal and a running template
+int16_t sqi_history[SQI_TEMPLATE_LEN] = {0};
+int16_t sqi_template[SQI_TEMPLATE_LEN] = {0};
+uint8_t sqi_history_offset = 0;
+uint8_t sqi_decimate = 0;
+bool sqi_template_valid = false;
+
+// Results
+SQI_scores_t sqi_scores = {0};
+uint32_t sqi_session_sum = 0;
+uint16_t sqi_session_windows = 0;
+
+/**
+ * Maps a value onto a 0-100 score that ramps up between bad and good
+ * @param value value to score
+ * @param bad value at or below which the score is 0
+ * @param good value at or above which the score is 100
+ * @return score from 0 to 100
+ */
+static uint8_t sqi_ramp(uint32_t value, uint32_t bad, uint32_t good) {
+    if (value <= bad) {
+        return 0;
+    }
+    if (value >= good) {
+        return 100;
+    }
+    return (uint8_t)((value - bad) * 100 / (good - bad));
+}
+
+/**
+ * Scores the beat that just finished against the interval average and template
+ */
+static void sqi_score_beat() {
+    // Beat interval consistency: deviation from the running average
+    uint16_t interval = sqi_samples_since_beat;
+    if (sqi_interval_average == 0) {
+        sqi_interval_average = interval;
+    }
+    uint16_t deviation = interval > sqi_interval_average ? interval - sqi_interval_average
+                                                         : sqi_interval_average - interval;
+    uint32_t deviation_pct = (uint32_t)deviation * 100 / sqi_interval_average;
+    sqi_scores.interval = deviation_pct >= 50 ? 0 : 100 - deviation_pct * 2;
+    sqi_interval_average += ((int16_t)interval - (int16_t)sqi_interval_average) / 4;
+
+    // Copy the history so it lines up with the template (oldest first)
+    int16_t beat[SQI_TEMPLATE_LEN];
+    for (uint8_t i = 0; i < SQI_TEMPLATE_LEN; i++) {
+        beat[i] = sqi_history[(sqi_history_offset + i) % SQI_TEMPLATE_LEN];
+    }
+
+    if (!sqi_template_valid) {
+        for (uint8_t i = 0; i < SQI_TEMPLATE_LEN; i++) {
+            sqi_template[i] = beat[i];
+        }
+        sqi_template_valid = true;
+        sqi_scores.morphology = 100;
+        return;
+    }
+
+    // Normalized correlation, only done once per beat so float is fine
+    float ab = 0, aa = 0, bb = 0;
+    for (uint8_t i = 0; i < SQI_TEMPLATE_LEN; i++) {
+        ab += (float)beat[i] * sqi_template[i];
+        aa += (float)beat[i] * beat[i];
+        bb += (float)sqi_template[i] * sqi_template[i];
+    }
+    float correlation = (aa > 0 && bb > 0) ? ab / sqrtf(aa * bb) : 0;
+    sqi_scores.morphology = correlation > 0 ? (uint8_t)(correlation * 100) : 0;
+
+    // Only let reasonable beats shape the template
+    if (sqi_scores.morphology >= SQI_MIN_QUALITY) {
+        for (uint8_t i = 0; i < SQI_TEMPLATE_LEN; i++) {
+            sqi_template[i] += (beat[i] - sqi_template[i]) / 8;
+        }
+    }
+}
+
+/**
+ * Scores the window that just finished and starts a new one
+ */
+static void sqi_finish_window() {
+    uint32_t ir_dc = sqi_ir_sum / sqi_count;
+    uint32_t red_dc = sqi_red_sum / sqi_count;
+    uint32_t ir_ac = sqi_ir_max - sqi_ir_min;
+    uint32_t red_ac = sqi_red_max - sqi_red_min;
+
+    // Perfusion index in 0.01% units, too high means motion rather than pulse
+    uint32_t pi = ir_dc ? ir_ac * 10000 / ir_dc : 0;
+    sqi_scores.perfusion = pi > SQI_PI_MAX ? 0 : sqi_ramp(pi, SQI_PI_MIN, SQI_PI_GOOD);
+
+    // Ratio of ratios in Q8 must be in a range that maps to a real SpO2
+    uint32_t ratio = 0;
+    if (ir_ac && red_dc) {
+        ratio = (uint32_t)(256.0f * red_ac * ir_dc / ((float)red_dc * ir_ac));
+    }
+    sqi_scores.ratio = (ratio >= SQI_RATIO_MIN && ratio <= SQI_RATIO_MAX) ? 100 : 0;
+
+    // Every clipped sample costs 10 points
+    sqi_scores.clipping = sqi_clipped >= 10 ? 0 : 100 - sqi_clipped * 10;
+
+    // Beat based scores go stale if the beats stop
+    if (sqi_windows_without_beat >= SQI_BEAT_TIMEOUT) {
+        sqi_scores.interval = 0;
+        sqi_scores.morphology = 0;
+    }
+    sqi_windows_without_beat++;
+
+    // Overall quality is the weakest score
+    uint8_t overall = sqi_scores.perfusion;
+    if (sqi_scores.ratio < overall) overall = sqi_scores.ratio;
+    if (sqi_scores.clipping < overall) overall = sqi_scores.clipping;
+    if (sqi_scores.interval < overall) overall = sqi_scores.interval;
+    if (sqi_scores.morphology < overall) overall = sqi_scores.morphology;
+    sqi_scores.overall = overall;
+
+    sqi_session_sum += overall;
+    sqi_session_windows++;
+
+    sqi_count = 0;
+    sqi_clipped = 0;
+}
+
+/**
+ * Adds a sample to the current quality window
+ * @param ir_raw IR value as read from the sensor
+ * @param red_raw red value as read from the sensor
+ * @param ir_ac filtered IR AC signal from the beat detector
+ * @param beat true if check_for_beat() detected a beat on this sample
+ */
+void sqi_update(uint32_t ir_raw, uint32_t red_raw, int16_t ir_ac, bool beat) {
+    if (sqi_count == 0) {
+        sqi_ir_min = sqi_ir_max = ir_raw;
+        sqi_red_min = sqi_red_max = red_raw;
+        sqi_ir_sum = 0;
+        sqi_red_sum = 0;
+    }
+
+    // Window statistics
+    if (ir_raw < sqi_ir_min) sqi_ir_min = ir_raw;
+    if (ir_raw > sqi_ir_max) sqi_ir_max = ir_raw;
+    if (red_raw < sqi_red_min) sqi_red_min = red_raw;
+    if (red_raw > sqi_red_max) sqi_red_max = red_raw;
+    sqi_ir_sum += ir_raw;
+    sqi_red_sum += red_raw;
+    if ((ir_raw >= SQI_CLIP_LEVEL || red_raw >= SQI_CLIP_LEVEL) && sqi_clipped < 255) {
+        sqi_clipped++;
+    }
+
+    // Keep a decimated history of the AC signal for the template
+    if (++sqi_decimate >= SQI_TEMPLATE_DECIMATION) {
+        sqi_decimate = 0;
+        sqi_history[sqi_history_offset] = ir_ac;
+        sqi_history_offset = (sqi_history_offset + 1) % SQI_TEMPLATE_LEN;
+    }
+
+    if (sqi_samples_since_beat < UINT16_MAX) {
+        sqi_samples_since_beat++;
+    }
+    if (beat) {
+        // The first beat only starts the interval, there is nothing to score
+        if (sqi_beat_seen) {
+            sqi_score_beat();
+        }
+        sqi_beat_seen = true;
+        sqi_samples_since_beat = 0;
+        sqi_windows_without_beat = 0;
+    }
+
+    if (++sqi_count >= SQI_WINDOW) {
+        sqi_finish_window();
+    }
+}
+
+/**
+ * Get the quality of the last finished window
+ * @return quality from 0 (unusable) to 100
+ */
+uint8_t sqi_get_quality() {
+    return sqi_scores.overall;
+}
+
+/**
+ * Check if the last finished window is good enough to update HR and SpO2
+ * @return true if the signal can be trusted
+ */
+bool sqi_is_good() {
+    return sqi_scores.overall >= SQI_MIN_QUALITY;
+}
+
+/**
+ * Get the individual scores of the last finished window
+ * @return pointer to the scores
+ */
+const SQI_scores_t *sqi_get_scores() {
+    return &sqi_scores;
+}
+
+/**
+ * Get the average quality of every window since the last reset
+ * @return average quality from 0 to 100
+ */
+uint8_t sqi_get_session_quality() {
+    if (sqi_session_windows == 0) {
+        return 0;
+    }
+    return (uint8_t)(sqi_session_sum / sqi_session_windows);
+}
+
+/**
+ * Reset the quality estimator to allow for a new reading
+ */
+void reset_sqi_globals() {
+    SQI_scores_t empty = {0};
+    sqi_scores = empty;
+    sqi_count = 0;
+    sqi_clipped = 0;
+    sqi_samples_since_beat = 0;
+    sqi_interval_average = 0;
+    sqi_windows_without_beat = 0;
+    sqi_beat_seen = false;
+    sqi_history_offset = 0;
+    sqi_decimate = 0;
+    sqi_template_valid = false;
+    sqi_session_sum = 0;
+    sqi_session_windows = 0;
+    for (uint8_t i = 0; i < SQI_TEMPLATE_LEN; i++) {
+        sqi_history[i] = 0;
+        sqi_template[i] = 0;
+    }
+}
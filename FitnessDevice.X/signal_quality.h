@@ -0,0 +1,51 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifndef SIGNAL_QUALITY_H
+#define	SIGNAL_QUALITY_H
+
+// Number of PPG samples in one quality window (1 second at 100 sps)
+#define SQI_WINDOW 100
+
+// Minimum quality (0-100) for a window to be allowed to update HR and SpO2
+#define SQI_MIN_QUALITY 50
+
+// Raw readings at or above this are treated as clipped (18-bit ADC)
+#define SQI_CLIP_LEVEL 0x3FF00
+
+// Perfusion index limits in 0.01% units
+#define SQI_PI_MIN 5
+#define SQI_PI_GOOD 20
+#define SQI_PI_MAX 2000
+
+// Red/IR ratio of ratios limits in Q8 (0.3 to 2.5)
+#define SQI_RATIO_MIN 77
+#define SQI_RATIO_MAX 640
+
+// Beat template, stored at half the sample rate
+#define SQI_TEMPLATE_LEN 32
+#define SQI_TEMPLATE_DECIMATION 2
+
+// Windows without a beat before the beat based scores are zeroed
+#define SQI_BEAT_TIMEOUT 2
+
+// Struct holding the scores of the last finished window
+typedef struct {
+    uint8_t perfusion;
+    uint8_t ratio;
+    uint8_t clipping;
+    uint8_t interval;
+    uint8_t morphology;
+    uint8_t overall;
+} SQI_scores_t;
+
+void sqi_update(uint32_t ir_raw, uint32_t red_raw, int16_t ir_ac, bool beat);
+uint8_t sqi_get_quality();
+bool sqi_is_good();
+const SQI_scores_t *sqi_get_scores();
+uint8_t sqi_get_session_quality();
+void reset_sqi_globals();
+
+#endif	/* SIGNAL_QUALITY_H */
+
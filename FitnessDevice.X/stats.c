@@ -0,0 +1,115 @@
+#include "stats.h"
+/*
+ * Streaming mean, variance, minimum and maximum that stay correct however
+ * long a session runs, in constant memory. Readings are first summed
+ * exactly in integers over a block of STATS_BLOCK samples, then the block is
+ * merged into the running mean and variance with the pairwise form of
+ * Welford's update (Chan et al.). The float division is paid once per block
+ * instead of once per sample, and the running values hold a mean and a
+ * variance rather than sums, so nothing grows with the session.
+ */
+
+/**
+ * Start the statistics over
+ * @param stats statistics to clear
+ */
+void stats_reset(stats_t *stats) {
+    stats->count = 0;
+    stats->mean = 0;
+    stats->variance = 0;
+    stats->min = UINT16_MAX;
+    stats->max = 0;
+    stats->block_count = 0;
+    stats->block_sum = 0;
+    stats->block_squares = 0;
+}
+
+/**
+ * Merge the block being summed into the running mean and variance
+ * @param stats statistics to update
+ */
+static void stats_merge(stats_t *stats) {
+    if (stats->block_count == 0) {
+        return;
+    }
+
+    float n = stats->block_count;
+    float block_mean = stats->block_sum / n;
+    float block_m2 = stats->block_squares - block_mean * stats->block_sum;
+    uint32_t total = stats->count + stats->block_count;
+    float delta = block_mean - stats->mean;
+
+    // Weight of the block in the combined values
+    float weight = n / total;
+    stats->mean += delta * weight;
+    stats->variance += (block_m2 / total) - stats->variance * weight + delta * delta * weight * (1 - weight);
+    stats->count = total;
+
+    stats->block_count = 0;
+    stats->block_sum = 0;
+    stats->block_squares = 0;
+}
+
+/**
+ * Add a reading
+ * @param stats statistics to update
+ * @param value reading from 0 to 1023
+ */
+void stats_add(stats_t *stats, uint16_t value) {
+    if (value < stats->min) {
+        stats->min = value;
+    }
+    if (value > stats->max) {
+        stats->max = value;
+    }
+
+    stats->block_sum += value;
+    stats->block_squares += (uint32_t)value * value;
+    if (++stats->block_count == STATS_BLOCK) {
+        stats_merge(stats);
+    }
+}
+
+/**
+ * Get the number of readings added
+ * @param stats statistics to read
+ * @return readings since the last reset
+ */
+uint32_t stats_count(const stats_t *stats) {
+    return stats->count + stats->block_count;
+}
+
+/**
+ * Get the mean of the readings
+ * @param stats statistics to read, the open block is merged first
+ * @return mean rounded to the nearest count
+ */
+uint16_t stats_mean(stats_t *stats) {
+    stats_merge(stats);
+    return (uint16_t)(stats->mean + 0.5f);
+}
+
+/**
+ * Get the standard deviation of the readings
+ * @param stats statistics to read, the open block is merged first
+ * @return population standard deviation rounded to the nearest count
+ */
+uint16_t stats_deviation(stats_t *stats) {
+    stats_merge(stats);
+    return stats->variance > 0 ? (uint16_t)(sqrtf(stats->variance) + 0.5f) : 0;
+}
+
+/**
+ * Compute a rounded fixed-point ratio
+ * @param num numerator, num * scale has to fit in 32 bits
+ * @param den denominator
+ * @param scale units of the result, 100 for percent, 1000 for tenths of one
+ * @return num / den * scale rounded, 0 if den is 0 and UINT16_MAX if too big
+ */
+uint16_t stats_ratio(uint32_t num, uint32_t den, uint16_t scale) {
+    if (den == 0) {
+        return 0;
+    }
+    uint32_t ratio = (num * scale + den / 2) / den;
+    return ratio > UINT16_MAX ? UINT16_MAX : ratio;
+}
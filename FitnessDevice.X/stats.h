@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifndef STATS_H
+#define	STATS_H
+
+// Samples summed exactly before they are merged into the running values.
+// 64 readings of up to 1023 keep the sum of squares within 32 bits.
+#define STATS_BLOCK 64
+
+// Running statistics of a stream of 10-bit readings
+typedef struct {
+    uint32_t count; // Samples merged into mean and variance
+    float mean;
+    float variance; // Population variance
+    uint16_t min;
+    uint16_t max;
+    uint8_t block_count; // Samples in the block being summed
+    uint32_t block_sum;
+    uint32_t block_squares;
+} stats_t;
+
+void stats_reset(stats_t *stats);
+void stats_add(stats_t *stats, uint16_t value);
+uint32_t stats_count(const stats_t *stats);
+uint16_t stats_mean(stats_t *stats);
+uint16_t stats_deviation(stats_t *stats);
+uint16_t stats_ratio(uint32_t num, uint32_t den, uint16_t scale);
+
+#endif	/* STATS_H */
@@ -0,0 +1,84 @@
+#include "telemetry.h"
+#include "newavr-main.h"
+/*
+ * Live telemetry during a set. The main loop takes a snapshot every
+ * TELEMETRY_INTERVAL_MS and hands it over with telemetry_update(). Only one
+ * snapshot waits for the BLE link, a newer one replaces it, so when the
+ * 9600 baud link or the peer falls behind the updates are coalesced instead
+ * of queued, and one that waited longer than TELEMETRY_STALE_MS is dropped.
+ * Sending only starts when the module is idle, by then the USART buffer is
+ * empty, so nothing here waits on the link and sampling is never held up.
+ */
+
+bool telemetry_enabled = false;
+uint32_t telemetry_last = 0; // Time of the last snapshot
+
+// Snapshot waiting for the link
+telemetry_t telemetry_pending;
+bool telemetry_has_pending = false;
+uint32_t telemetry_pending_time = 0;
+uint8_t telemetry_sequence = 0;
+uint16_t telemetry_drops = 0;
+
+/**
+ * Start or stop the telemetry, a snapshot still waiting is dropped on stop
+ * @param enable true to send snapshots
+ */
+void telemetry_enable(bool enable) {
+    if (enable && !telemetry_enabled) {
+        telemetry_last = millis();
+    }
+    if (!enable) {
+        telemetry_has_pending = false;
+    }
+    telemetry_enabled = enable;
+}
+
+/**
+ * Check if it is time for the next snapshot
+ * @return true if telemetry is on and the interval has passed
+ */
+bool telemetry_due() {
+    return telemetry_enabled && millis() - telemetry_last >= TELEMETRY_INTERVAL_MS;
+}
+
+/**
+ * Queue a snapshot, replacing one that has not been sent yet
+ * @param snapshot values to send, its sequence is filled in
+ */
+void telemetry_update(telemetry_t *snapshot) {
+    telemetry_last = millis();
+    snapshot->sequence = telemetry_sequence++;
+
+    if (telemetry_has_pending) {
+        telemetry_drops++;
+    }
+    telemetry_pending = *snapshot;
+    telemetry_pending_time = telemetry_last;
+    telemetry_has_pending = true;
+}
+
+/**
+ * Send the waiting snapshot once the module is free, call from the main loop
+ */
+void telemetry_task() {
+    if (!telemetry_has_pending) {
+        return;
+    }
+    if (millis() - telemetry_pending_time >= TELEMETRY_STALE_MS) {
+        telemetry_has_pending = false;
+        telemetry_drops++;
+        return;
+    }
+    if (BLE_send_data(BLE_TELEMETRY_HANDLE, (const uint8_t *)&telemetry_pending, sizeof(telemetry_pending))) {
+        telemetry_has_pending = false;
+    }
+}
+
+/**
+ * Get the number of snapshots replaced or dropped before they were sent
+ * @return dropped snapshots since startup
+ */
+uint16_t telemetry_dropped() {
+    return telemetry_drops;
+}
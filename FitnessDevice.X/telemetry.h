@@ -0,0 +1,43 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "bluetooth.h"
+#include "acquisition.h"
+
+#ifndef TELEMETRY_H
+#define	TELEMETRY_H
+
+// Time between snapshots, set here since the app has no way to change it,
+// and the least it may be. At 9600 baud one notification (a 38 character SHW
+// command and the module's reply) takes about 50 ms of the link.
+#define TELEMETRY_INTERVAL_MS 250
+#define TELEMETRY_MIN_INTERVAL_MS 50
+
+#if TELEMETRY_INTERVAL_MS < TELEMETRY_MIN_INTERVAL_MS
+#error "Telemetry interval leaves no time for the rest of the link"
+#endif
+
+// A snapshot still unsent after this long is dropped instead of sent
+#define TELEMETRY_STALE_MS 1000
+
+// Snapshot notified on the telemetry characteristic, little endian
+typedef struct {
+    uint8_t sequence; // Counts every snapshot, a gap means one was dropped
+    uint8_t state; // device_state_t the snapshot was taken in
+    uint8_t bpm; // Average heart rate
+    uint8_t spo2; // Blood oxygen
+    uint8_t quality; // Signal quality of the last PPG window 0-100
+    uint16_t envelope[EMG_CHANNELS]; // Smoothed reading of each muscle sensor
+    uint16_t median_freq; // EMG median frequency of the last window in 0.1 Hz
+} telemetry_t;
+
+#if 7 + 2 * EMG_CHANNELS > BLE_MAX_DATA
+#error "Telemetry snapshot does not fit in one notification"
+#endif
+
+void telemetry_enable(bool enable);
+bool telemetry_due();
+void telemetry_update(telemetry_t *snapshot);
+void telemetry_task();
+uint16_t telemetry_dropped();
+
+#endif	/* TELEMETRY_H */
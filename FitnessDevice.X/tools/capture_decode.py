@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+Decoder for the raw sample capture stream (capture.c).
+
+Reads frames from a serial port or a file of captured bytes, checks their
+CRC and sequence numbers, and writes the samples as CSV and optionally NPY.
+
+    python3 tools/capture_decode.py /dev/ttyUSB0 -o session.csv --npy session.npy
+    python3 tools/capture_decode.py capture.bin -o session.csv
+
+Reading a serial port needs pyserial. The NPY file is an int64 array with
+one row per sample: time_ms, type (0 EMG, 1 PPG), emg, ir, red. EMG rows are
+the first muscle sensor at 500 sps, PPG rows the sensor samples at 400 sps
+before decimation. Stop a live capture with Ctrl-C, the summary lists CRC
+errors and dropped frames.
+"""
+import argparse
+import csv
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+HEADER = 6
+TRAILER = 2
+BAUD = 250000
+
+FRAME_EMG = 0x01
+FRAME_PPG = 0x02
+PAYLOAD = {FRAME_EMG: 2, FRAME_PPG: 8}
+
+
+def crc_ccitt_update(crc, data):
+    """Same as _crc_ccitt_update from avr-libc."""
+    data ^= crc & 0xFF
+    data = (data ^ (data << 4)) & 0xFF
+    return (((data << 8) | (crc >> 8)) ^ (data >> 4) ^ (data << 3)) & 0xFFFF
+
+
+def crc_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc = crc_ccitt_update(crc, byte)
+    return crc
+
+
+class Decoder:
+    """Turns a byte stream into samples, keeping count of errors and gaps."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.frames = 0
+        self.crc_errors = 0
+        self.dropped = 0
+        self.last_sequence = None
+        self.time_high = 0
+        self.last_time = None
+
+    def _unwrap_time(self, time_low):
+        # Frames only carry the low 16 bits of the ms timestamp
+        if self.last_time is not None and time_low < (self.last_time & 0xFFFF) - 0x8000:
+            self.time_high += 0x10000
+        self.last_time = self.time_high + time_low
+        return self.last_time
+
+    def feed(self, data):
+        """Add bytes and return the samples completed by them."""
+        self.buffer += data
+        samples = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # Keep a trailing first sync byte
+                del self.buffer[:max(0, len(self.buffer) - 1)]
+                return samples
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER:
+                return samples
+
+            kind = self.buffer[3]
+            if kind not in PAYLOAD:
+                del self.buffer[:1]  # Not a frame, look for the next sync
+                continue
+            length = HEADER + PAYLOAD[kind] + TRAILER
+            if len(self.buffer) < length:
+                return samples
+
+            frame = bytes(self.buffer[:length])
+            crc = struct.unpack_from("<H", frame, length - TRAILER)[0]
+            if crc != crc_ccitt(frame[2:length - TRAILER]):
+                self.crc_errors += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:length]
+            samples.append(self._decode(frame, kind))
+
+    def _decode(self, frame, kind):
+        sequence = frame[2]
+        if self.last_sequence is not None:
+            self.dropped += (sequence - self.last_sequence - 1) & 0xFF
+        self.last_sequence = sequence
+        self.frames += 1
+
+        time_ms = self._unwrap_time(struct.unpack_from("<H", frame, 4)[0])
+        emg = struct.unpack_from("<H", frame, 6)[0]
+        if kind == FRAME_PPG:
+            ir = int.from_bytes(frame[8:11], "little")
+            red = int.from_bytes(frame[11:14], "little")
+            return (time_ms, "ppg", emg, ir, red)
+        return (time_ms, "emg", emg, "", "")
+
+
+def write_npy(path, rows):
+    """Write the samples as an (n, 5) int64 .npy file without needing numpy."""
+    header = "{'descr': '<i8', 'fortran_order': False, 'shape': (%d, 5), }" % len(rows)
+    # Magic, version and header length take 10 bytes, pad the header so the
+    # data starts on a 64 byte boundary
+    header += " " * (63 - (10 + len(header)) % 64) + "\n"
+    with open(path, "wb") as out:
+        out.write(b"\x93NUMPY\x01\x00" + struct.pack("<H", len(header)) + header.encode("latin1"))
+        for t, kind, emg, ir, red in rows:
+            out.write(struct.pack("<5q", t, 1 if kind == "ppg" else 0, emg, ir or 0, red or 0))
+
+
+def open_source(path):
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial  # pyserial
+        return serial.Serial(path, BAUD, timeout=0.1)
+    return open(path, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("source", help="serial port or file of captured bytes")
+    parser.add_argument("-o", "--csv", required=True, help="CSV file to write")
+    parser.add_argument("--npy", help="also write the samples as a NumPy array")
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    rows = []
+    source = open_source(args.source)
+    with open(args.csv, "w", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(["time_ms", "type", "emg", "ir", "red"])
+        try:
+            while True:
+                data = source.read(4096)
+                if not data:
+                    if hasattr(source, "in_waiting"):
+                        continue  # Serial port, keep listening
+                    break
+                for row in decoder.feed(data):
+                    writer.writerow(row)
+                    rows.append(row)
+        except KeyboardInterrupt:
+            pass
+    source.close()
+
+    if args.npy:
+        write_npy(args.npy, rows)
+
+    print("frames %d, dropped %d, crc errors %d" % (decoder.frames, decoder.dropped, decoder.crc_errors),
+          file=sys.stderr)
+    return 1 if decoder.dropped or decoder.crc_errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""
+Generates fir_coeffs.h, the low-pass FIR tables used by max30102_math.c.
+
+Each profile is a Hamming windowed sinc for one PPG_SAMPLE_RATE. The taps
+scale with the rate so every profile has the same response in Hz as the
+original 23 tap, 100 Hz filter. The tables are Q15 and keep the original DC
+gain, so the beat amplitude window in max30102_math.c means the same thing at
+every rate. Only the half of the symmetric table up to the center tap is
+stored. The header picks the table for PPG_SAMPLE_RATE at compile time and
+stops the build when there is none.
+
+    python3 tools/fir_design.py
+"""
+import math
+import os
+
+# sample rate (Hz): (windowed sinc cutoff in Hz, taps)
+PROFILES = {
+    50: (1.5, 11),
+    100: (1.5, 23),
+    200: (1.5, 45),
+}
+
+# DC gain of the original filter, the beat thresholds are tuned to it
+GAIN = 1.449
+Q15 = 32768
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "fir_coeffs.h")
+
+
+def design(rate, cutoff, taps):
+    """Q15 coefficients up to and including the center tap."""
+    fc = cutoff / rate
+    mid = (taps - 1) / 2
+    h = []
+    for n in range(taps):
+        x = n - mid
+        sinc = 2 * fc if x == 0 else math.sin(2 * math.pi * fc * x) / (math.pi * x)
+        h.append(sinc * (0.54 - 0.46 * math.cos(2 * math.pi * n / (taps - 1))))
+    scale = GAIN * Q15 / sum(h)
+    half = [round(v * scale) for v in h[: taps // 2 + 1]]
+
+    # Put the rounding error on the center tap so the DC gain is exact
+    half[-1] += round(GAIN * Q15) - (2 * sum(half[:-1]) + half[-1])
+    return half
+
+
+def response(half, rate, freq):
+    """Gain at freq relative to DC."""
+    h = half[:-1] + [half[-1]] + half[-2::-1]
+    re = sum(c * math.cos(2 * math.pi * freq / rate * n) for n, c in enumerate(h))
+    im = sum(c * math.sin(2 * math.pi * freq / rate * n) for n, c in enumerate(h))
+    return math.hypot(re, im) / sum(h)
+
+
+def corner(half, rate):
+    """-3 dB frequency in Hz, to 0.1 Hz."""
+    freq = 0.0
+    while response(half, rate, freq) > math.sqrt(0.5):
+        freq += 0.1
+    return freq
+
+
+def main():
+    lines = [
+        "// Generated by tools/fir_design.py, do not edit",
+        "#include <stdint.h>",
+        "",
+        "#ifndef FIR_COEFFS_H",
+        "#define\tFIR_COEFFS_H",
+        "",
+        "// Q15 low-pass taps from the first tap to the center tap, the other half",
+        "// mirrors them. FIR_BUFFER is the power of two history the filter keeps.",
+    ]
+    for i, (rate, (cutoff, taps)) in enumerate(sorted(PROFILES.items())):
+        half = design(rate, cutoff, taps)
+        buffer = 1
+        while buffer < taps:
+            buffer *= 2
+        lines += [
+            "%s PPG_SAMPLE_RATE == %d" % ("#if" if i == 0 else "#elif", rate),
+            "// %d taps, -3 dB at %.1f Hz" % (taps, corner(half, rate)),
+            "#define FIR_TAPS %d" % taps,
+            "#define FIR_BUFFER %d" % buffer,
+            "static const int16_t FIRCoeffs[%d] = {" % len(half),
+        ]
+        for start in range(0, len(half), 12):
+            row = ", ".join(str(c) for c in half[start:start + 12])
+            lines.append("    %s%s" % (row, "," if start + 12 < len(half) else ""))
+        lines.append("};")
+    lines += [
+        "#else",
+        '#error "No FIR table for PPG_SAMPLE_RATE, add a profile to tools/fir_design.py"',
+        "#endif",
+        "",
+        "#endif\t/* FIR_COEFFS_H */",
+        "",
+    ]
+    with open(HEADER, "w") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
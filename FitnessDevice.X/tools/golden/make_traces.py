@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""
+Generates the synthetic golden traces in traces/.
+
+Each trace is 100 Hz PPG (the rate max30102_math.c runs at) with EMG and the
+ground truth heart rate and SpO2 for every sample. The red channel is built
+so that the ratio of ratios gives the true SpO2 through the firmware's
+default calibration curve, SpO2 = 110 - 25 * R. The generator is seeded, so
+running it again gives the same files.
+
+    python3 make_traces.py
+"""
+import math
+import os
+import random
+
+RATE = 100
+DURATION = 20  # seconds
+SPO2_A = 110.0
+SPO2_B = 25.0
+
+# name: (start bpm, end bpm, spo2, IR AC peak to peak, noise, motion amplitude)
+TRACES = {
+    "rest_60": (60, 60, 98, 500, 8, 0),
+    "rest_75": (75, 75, 96, 450, 8, 0),
+    "ramp_80_120": (80, 120, 97, 450, 10, 0),
+    "exercise_140": (140, 140, 95, 400, 15, 120),
+    "low_perfusion": (70, 70, 97, 90, 6, 0),
+    "hypoxic_88": (85, 85, 88, 450, 8, 0),
+}
+
+IR_DC = 120000
+RED_DC = 90000
+
+
+def pulse(phase):
+    """Blood volume over one beat, systolic peak and a dicrotic wave."""
+    return (math.exp(-((phase - 0.18) / 0.07) ** 2)
+            + 0.35 * math.exp(-((phase - 0.45) / 0.09) ** 2))
+
+
+def make_trace(name, start_bpm, end_bpm, spo2, ir_ac, noise, motion):
+    rng = random.Random(name)
+    ratio = (SPO2_A - spo2) / SPO2_B
+    red_ac = ratio * (ir_ac / IR_DC) * RED_DC
+    peak = max(pulse(i / 1000) for i in range(1000))
+
+    rows = []
+    phase = 0.0
+    for n in range(RATE * DURATION):
+        t = n / RATE
+        bpm = start_bpm + (end_bpm - start_bpm) * t / DURATION
+        phase = (phase + bpm / 60 / RATE) % 1.0
+
+        # More blood absorbs more light, so the reading dips on each beat
+        p = pulse(phase) / peak
+        wander = 0.002 * math.sin(2 * math.pi * 0.1 * t)
+        artifact = motion * math.sin(2 * math.pi * 1.7 * t + 0.6 * math.sin(2 * math.pi * 0.3 * t))
+        ir = IR_DC * (1 + wander) - ir_ac * p + artifact + rng.gauss(0, noise)
+        red = RED_DC * (1 + wander) - red_ac * p + artifact * RED_DC / IR_DC + rng.gauss(0, noise)
+
+        # Muscle activity bursts along with the motion
+        emg = 300 + rng.gauss(0, 15) + (abs(artifact) * 1.5 if motion else 0)
+
+        rows.append("%d,%d,%d,%d,%.1f,%d" % (n * 1000 // RATE, ir, red, emg, bpm, spo2))
+
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "traces", name + ".csv")
+    with open(path, "w") as f:
+        f.write("time_ms,ir,red,emg,bpm,spo2\n")
+        f.write("\n".join(rows) + "\n")
+
+
+def main():
+    for name, params in TRACES.items():
+        make_trace(name, *params)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,256 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "max30102_math.h"
+/*
+ * Golden trace runner for the PPG math, built natively on Linux from the same
+ * max30102_math.c the firmware uses.
+ *
+ * It replays one trace from traces/ through the heart rate and SpO2 pipeline
+ * of sense_HRBO (check_for_beat, average_beat and calculate_and_update_spo2)
+ * and scores the output against the ground truth columns. Motion
+ * cancellation and the signal quality gate are left out, the traces are clean
+ * enough that SQI would pass every beat. The whole trace is then replayed
+ * until TIME_BUDGET_NS has passed to measure samples per second. Only the
+ * accuracy is checked against the baseline, the throughput depends on the
+ * machine and is just reported.
+ *
+ * The math keeps its state in globals, so each trace gets its own process.
+ * The Makefile runs one trace per call.
+ *
+ *   ./runner traces/rest_60.csv                      print the result line
+ *   ./runner traces/rest_60.csv baselines.txt        compare with the baseline
+ *
+ * Result line: name expected_beats found_beats bpm_mae spo2_error samples_per_s
+ */
+
+// Traces are 100 Hz, at most a minute long
+#define MAX_SAMPLES 6000
+
+// Error metrics skip the first seconds while the filters settle
+#define WARMUP_MS 5000
+
+// Throughput measurement length
+#define TIME_BUDGET_NS 200000000LL
+
+// Allowed regression against the baseline
+#define BEAT_TOLERANCE 2
+#define BPM_TOLERANCE 1.0
+#define SPO2_TOLERANCE 1.0
+
+typedef struct {
+    uint32_t time_ms;
+    int32_t ir;
+    int32_t red;
+    double bpm;
+    double spo2;
+} trace_sample_t;
+
+typedef struct {
+    char name[64];
+    int expected_beats;
+    int found_beats;
+    double bpm_mae;
+    double spo2_error;
+    double samples_per_s;
+} result_t;
+
+trace_sample_t trace[MAX_SAMPLES];
+int trace_length = 0;
+
+/**
+ * Load a trace CSV (time_ms,ir,red,emg,bpm,spo2)
+ * @param path trace file
+ * @return true if at least one sample was read
+ */
+static bool load_trace(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    char line[128];
+    // Skip the header
+    if (fgets(line, sizeof(line), f) == NULL) {
+        fclose(f);
+        return false;
+    }
+
+    while (trace_length < MAX_SAMPLES && fgets(line, sizeof(line), f) != NULL) {
+        trace_sample_t *s = &trace[trace_length];
+        int emg;
+        if (sscanf(line, "%u,%d,%d,%d,%lf,%lf", &s->time_ms, &s->ir, &s->red, &emg, &s->bpm, &s->spo2) == 6) {
+            trace_length++;
+        }
+    }
+    fclose(f);
+    return trace_length > 0;
+}
+
+/**
+ * Run the trace through the pipeline and score it against the truth
+ * @param result filled with the error metrics
+ */
+static void score_trace(result_t *result) {
+    uint32_t last_beat = 0;
+    float average_bpm = 0;
+    float spo2 = 0;
+
+    double expected = 0;
+    double bpm_error = 0;
+    int bpm_count = 0;
+
+    reset_math_globals();
+    for (int i = 0; i < trace_length; i++) {
+        trace_sample_t *s = &trace[i];
+
+        bool beat = check_for_beat(s->ir);
+        bool keep = false;
+        if (beat) {
+            uint32_t delta = s->time_ms - last_beat;
+            last_beat = s->time_ms;
+
+            keep = average_beat(delta, &average_bpm);
+            if (s->time_ms >= WARMUP_MS) {
+                result->found_beats++;
+            }
+        }
+        calculate_and_update_spo2(s->ir, s->red, beat, keep, &spo2);
+
+        if (s->time_ms < WARMUP_MS) {
+            continue;
+        }
+        expected += s->bpm / 60.0 / 100.0;
+        bpm_error += average_bpm > s->bpm ? average_bpm - s->bpm : s->bpm - average_bpm;
+        bpm_count++;
+    }
+
+    double truth_spo2 = trace[trace_length - 1].spo2;
+    result->expected_beats = (int)(expected + 0.5);
+    result->bpm_mae = bpm_count ? bpm_error / bpm_count : 0;
+    result->spo2_error = spo2 > truth_spo2 ? spo2 - truth_spo2 : truth_spo2 - spo2;
+}
+
+/**
+ * Time replays of the trace
+ * @return samples processed per second
+ */
+static double measure_throughput(void) {
+    struct timespec start, now;
+    long long elapsed = 0;
+    long long samples = 0;
+    float spo2 = 0;
+    int beats = 0;
+
+    reset_math_globals();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (elapsed < TIME_BUDGET_NS) {
+        for (int i = 0; i < trace_length; i++) {
+            bool beat = check_for_beat(trace[i].ir);
+            calculate_and_update_spo2(trace[i].ir, trace[i].red, beat, beat, &spo2);
+            beats += beat;
+        }
+        samples += trace_length;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed = (now.tv_sec - start.tv_sec) * 1000000000LL + (now.tv_nsec - start.tv_nsec);
+    }
+
+    // Keep the compiler from dropping the work
+    if (beats < 0 || spo2 < 0) {
+        fprintf(stderr, "unexpected output\n");
+    }
+    return samples * 1e9 / elapsed;
+}
+
+/**
+ * Find the baseline for a trace
+ * @param path baselines file, one result line per trace
+ * @param name trace name
+ * @param baseline filled when found
+ * @return true if the trace has a baseline
+ */
+static bool load_baseline(const char *path, const char *name, result_t *baseline) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    char line[256];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') {
+            continue;
+        }
+        found = sscanf(line, "%63s %d %d %lf %lf %lf", baseline->name, &baseline->expected_beats,
+                       &baseline->found_beats, &baseline->bpm_mae, &baseline->spo2_error,
+                       &baseline->samples_per_s) == 6 && strcmp(baseline->name, name) == 0;
+    }
+    fclose(f);
+    return found;
+}
+
+/**
+ * Compare a result with its baseline and report every regression, the
+ * throughput is only shown next to the baseline's
+ * @return true if the accuracy did not regress
+ */
+static bool check_baseline(const result_t *result, const result_t *baseline) {
+    bool ok = true;
+    int beat_miss = abs(result->found_beats - result->expected_beats);
+    int base_miss = abs(baseline->found_beats - baseline->expected_beats);
+
+    if (beat_miss > base_miss + BEAT_TOLERANCE) {
+        fprintf(stderr, "%s: beats off by %d, baseline %d\n", result->name, beat_miss, base_miss);
+        ok = false;
+    }
+    if (result->bpm_mae > baseline->bpm_mae + BPM_TOLERANCE) {
+        fprintf(stderr, "%s: BPM error %.2f, baseline %.2f\n", result->name, result->bpm_mae, baseline->bpm_mae);
+        ok = false;
+    }
+    if (result->spo2_error > baseline->spo2_error + SPO2_TOLERANCE) {
+        fprintf(stderr, "%s: SpO2 error %.2f, baseline %.2f\n", result->name, result->spo2_error, baseline->spo2_error);
+        ok = false;
+    }
+    printf("%s: %.2fx the baseline's samples/s (not checked)\n", result->name,
+           baseline->samples_per_s > 0 ? result->samples_per_s / baseline->samples_per_s : 0);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s trace.csv [baselines.txt]\n", argv[0]);
+        return 2;
+    }
+    if (!load_trace(argv[1])) {
+        return 2;
+    }
+
+    // Trace name is the file name without directory and extension
+    result_t result = {0};
+    const char *base = strrchr(argv[1], '/');
+    snprintf(result.name, sizeof(result.name), "%s", base ? base + 1 : argv[1]);
+    char *dot = strrchr(result.name, '.');
+    if (dot != NULL) {
+        *dot = '\0';
+    }
+
+    score_trace(&result);
+    result.samples_per_s = measure_throughput();
+    printf("%s %d %d %.2f %.2f %.0f\n", result.name, result.expected_beats, result.found_beats,
+           result.bpm_mae, result.spo2_error, result.samples_per_s);
+
+    if (argc == 3) {
+        result_t baseline = {0};
+        if (!load_baseline(argv[2], result.name, &baseline)) {
+            fprintf(stderr, "%s: no baseline\n", result.name);
+            return 1;
+        }
+        return check_baseline(&result, &baseline) ? 0 : 1;
+    }
+    return 0;
+}
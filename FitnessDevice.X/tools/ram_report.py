@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+RAM and flash report for the firmware image.
+
+Section totals come from the linker map and per symbol sizes from avr-nm on
+the matching ELF. Exits with status 1 when the RAM or flash total is over its
+budget, so it can guard the build before new buffers go in.
+
+    python3 tools/ram_report.py --map dist/default/production/FitnessDevice.X.production.map \
+        --elf dist/default/production/FitnessDevice.X.production.elf --ram-budget 3584
+"""
+import argparse
+import re
+import subprocess
+import sys
+
+# Output sections and the memory they take up. .data is in RAM and its
+# initial values are also stored in flash.
+RAM_SECTIONS = (".data", ".bss", ".noinit")
+FLASH_SECTIONS = (".text", ".rodata", ".data")
+
+SECTION_RE = re.compile(r"^(\.\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+SECTION_NAME_RE = re.compile(r"^(\.\w+)\s*$")
+SECTION_CONT_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+
+def read_sections(map_path):
+    """Sizes of the output sections listed in the memory map."""
+    sizes = {}
+    in_memory_map = False
+    pending = None
+    with open(map_path) as f:
+        for line in f:
+            if line.startswith("Linker script and memory map"):
+                in_memory_map = True
+                continue
+            if not in_memory_map:
+                continue
+
+            # Long names put the address and size on the next line
+            if pending:
+                m = SECTION_CONT_RE.match(line)
+                if m:
+                    sizes[pending] = sizes.get(pending, 0) + int(m.group(2), 16)
+                pending = None
+                continue
+
+            m = SECTION_RE.match(line)
+            if m:
+                sizes[m.group(1)] = sizes.get(m.group(1), 0) + int(m.group(3), 16)
+                continue
+            m = SECTION_NAME_RE.match(line)
+            if m:
+                pending = m.group(1)
+    return sizes
+
+
+def read_symbols(nm, elf_path):
+    """(size, type, name) for every symbol with a size, largest first."""
+    try:
+        out = subprocess.run([nm, "-S", "--size-sort", "-t", "d", elf_path],
+                             check=True, capture_output=True, text=True).stdout
+    except (OSError, subprocess.CalledProcessError) as err:
+        print("warning: no per symbol sizes (%s)" % err, file=sys.stderr)
+        return []
+
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            symbols.append((int(fields[1]), fields[2], fields[3]))
+    symbols.sort(reverse=True)
+    return symbols
+
+
+def print_symbols(title, symbols, types, top):
+    selected = [s for s in symbols if s[1] in types]
+    print("%s (%d symbols, %d bytes)" % (title, len(selected), sum(s[0] for s in selected)))
+    for size, kind, name in selected[:top]:
+        print("  %6d  %s  %s" % (size, kind, name))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--map", required=True, help="linker map file")
+    parser.add_argument("--elf", help="ELF image for per symbol sizes")
+    parser.add_argument("--nm", default="avr-nm", help="nm program for the target")
+    parser.add_argument("--ram-budget", type=int, default=0, help="bytes of static RAM allowed, 0 for no limit")
+    parser.add_argument("--flash-budget", type=int, default=0, help="bytes of flash allowed, 0 for no limit")
+    parser.add_argument("--top", type=int, default=20, help="symbols listed per memory")
+    args = parser.parse_args()
+
+    sections = read_sections(args.map)
+    ram = sum(sections.get(s, 0) for s in RAM_SECTIONS)
+    flash = sum(sections.get(s, 0) for s in FLASH_SECTIONS)
+
+    if args.elf:
+        symbols = read_symbols(args.nm, args.elf)
+    else:
+        symbols = []
+    if symbols:
+        print_symbols("RAM", symbols, "bBdD", args.top)
+        print_symbols("Flash", symbols, "tTrRwW", args.top)
+
+    for name in RAM_SECTIONS + FLASH_SECTIONS[:2]:
+        print("%-8s %6d" % (name, sections.get(name, 0)))
+    print()
+
+    failed = False
+    for label, used, budget in (("RAM", ram, args.ram_budget), ("Flash", flash, args.flash_budget)):
+        if budget:
+            print("%-5s %6d / %6d bytes (%d%%)" % (label, used, budget, 100 * used // budget))
+            if used > budget:
+                print("error: %s is %d bytes over budget" % (label, used - budget), file=sys.stderr)
+                failed = True
+        else:
+            print("%-5s %6d bytes" % (label, used))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,196 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+/*
+ * Host stress test for ring.h.
+ *
+ * The simulation replays random interleavings of producer and consumer
+ * steps on one thread against a reference queue, so every full, empty and
+ * wrap-around case is checked for exact behavior. The threaded test then
+ * runs a real producer and consumer thread and checks that every record
+ * arrives once, in order and intact, which catches a missing acquire or
+ * release when the threads run on separate cores. A side that finds the
+ * ring full or empty yields, so the test also finishes on a single core.
+ *
+ *   make check
+ */
+
+// Typed record like the ones the firmware passes through its rings
+typedef struct {
+    uint32_t sequence;
+    uint16_t value[3];
+    uint16_t check; // Depends on everything above, a torn record fails it
+} record_t;
+
+#define SIM_STEPS 2000000
+#define THREAD_RECORDS 2000000UL
+
+RING_DEFINE(sim_ring, record_t, 8);
+RING_DEFINE(byte_ring, uint8_t, 128);
+RING_DEFINE(thread_ring, record_t, 32);
+
+/**
+ * Fill a record from its sequence number
+ * @param record record to fill
+ * @param sequence sequence number
+ */
+static void make_record(record_t *record, uint32_t sequence) {
+    record->sequence = sequence;
+    record->value[0] = sequence * 7;
+    record->value[1] = sequence >> 3;
+    record->value[2] = ~sequence;
+    record->check = (uint16_t)(sequence * 31 + record->value[0] + record->value[1] + record->value[2]);
+}
+
+/**
+ * Check a record against the sequence number it should have
+ * @return true if the record is the expected one and intact
+ */
+static bool check_record(const record_t *record, uint32_t sequence) {
+    record_t expected;
+    make_record(&expected, sequence);
+    return memcmp(record, &expected, sizeof(expected)) == 0;
+}
+
+/**
+ * Interleave producer and consumer steps at random on one thread
+ * @param ring ring of record_t under test
+ * @param size number of items the ring holds
+ * @return number of failures
+ */
+static int simulate(ring_t *ring, uint8_t size) {
+    uint32_t pushed = 0, popped = 0;
+    int failures = 0;
+
+    ring_reset(ring);
+    srand(1);
+    for (long step = 0; step < SIM_STEPS && failures < 10; step++) {
+        uint32_t waiting = pushed - popped;
+        record_t record;
+
+        if (ring_count(ring) != waiting || ring_space(ring) != size - waiting) {
+            printf("sim: count %u space %u, expected %u\n", ring_count(ring), ring_space(ring), waiting);
+            failures++;
+        }
+
+        // Bursts on either side so the ring spends time both full and empty
+        int burst = rand() % (size + 2);
+        if (rand() & 1) {
+            for (int i = 0; i < burst; i++) {
+                make_record(&record, pushed);
+                bool ok = ring_push(ring, &record);
+                if (ok != (pushed - popped < size)) {
+                    printf("sim: push returned %d with %u waiting\n", ok, pushed - popped);
+                    failures++;
+                }
+                pushed += ok;
+            }
+        } else {
+            for (int i = 0; i < burst; i++) {
+                bool ok = ring_pop(ring, &record);
+                if (ok != (pushed != popped)) {
+                    printf("sim: pop returned %d with %u waiting\n", ok, pushed - popped);
+                    failures++;
+                } else if (ok && !check_record(&record, popped)) {
+                    printf("sim: record %u wrong\n", popped);
+                    failures++;
+                }
+                popped += ok;
+            }
+        }
+    }
+    printf("sim: %u records through a ring of %u, %d failures\n", popped, size, failures);
+    return failures;
+}
+
+/**
+ * Same as simulate() for a byte ring using the zero copy calls
+ * @return number of failures
+ */
+static int simulate_bytes(void) {
+    uint32_t pushed = 0, popped = 0;
+    int failures = 0;
+
+    srand(2);
+    for (long step = 0; step < SIM_STEPS && failures < 10; step++) {
+        int burst = rand() % 140;
+        if (rand() & 1) {
+            for (int i = 0; i < burst; i++) {
+                uint8_t *slot = ring_slot(&byte_ring);
+                if ((slot != NULL) != (pushed - popped < 128)) {
+                    failures++;
+                }
+                if (slot != NULL) {
+                    *slot = (uint8_t)(pushed++ * 13);
+                    ring_commit(&byte_ring);
+                }
+            }
+        } else {
+            for (int i = 0; i < burst; i++) {
+                const uint8_t *byte = ring_front(&byte_ring);
+                if ((byte != NULL) != (pushed != popped)) {
+                    failures++;
+                }
+                if (byte != NULL) {
+                    failures += *byte != (uint8_t)(popped++ * 13);
+                    ring_drop(&byte_ring);
+                }
+            }
+        }
+    }
+    printf("sim: %u bytes through a ring of 128, %d failures\n", popped, failures);
+    return failures;
+}
+
+/**
+ * Producer thread, pushes THREAD_RECORDS records as fast as the ring allows
+ */
+static void *producer(void *arg) {
+    (void)arg;
+    for (uint32_t sequence = 0; sequence < THREAD_RECORDS; sequence++) {
+        record_t *slot;
+        while ((slot = ring_slot(&thread_ring)) == NULL) {
+            sched_yield();
+        }
+        make_record(slot, sequence);
+        ring_commit(&thread_ring);
+    }
+    return NULL;
+}
+
+/**
+ * Run a producer thread against a consumer on this thread
+ * @return number of failures
+ */
+static int threaded(void) {
+    pthread_t thread;
+    int failures = 0;
+
+    ring_reset(&thread_ring);
+    pthread_create(&thread, NULL, producer, NULL);
+    for (uint32_t sequence = 0; sequence < THREAD_RECORDS; sequence++) {
+        const record_t *record;
+        while ((record = ring_front(&thread_ring)) == NULL) {
+            sched_yield();
+        }
+        if (!check_record(record, sequence) && failures++ < 10) {
+            printf("threads: record %u wrong (got sequence %u)\n", sequence, record->sequence);
+        }
+        ring_drop(&thread_ring);
+    }
+    pthread_join(thread, NULL);
+    printf("threads: %lu records, %d failures\n", THREAD_RECORDS, failures);
+    return failures;
+}
+
+int main(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    int failures = simulate(&sim_ring, 8);
+    failures += simulate_bytes();
+    failures += threaded();
+    return failures ? 1 : 0;
+}